@@ -1,14 +1,12 @@
 #version 330
 
-#define MAX_LIGHTS 16
-
 #define DIRECTIONAL 0
 #define POINT 1
 #define SPOT 2
 
 struct Light {
-    int type;
     vec3 position;
+    int type;
     vec3 direction;
     vec3 diffuse;
     vec3 specular;
@@ -16,15 +14,42 @@ struct Light {
     vec2 cone_angles; // x: inner_angle, y: outer_angle
 };
 
-uniform Light lights[MAX_LIGHTS];
-uniform int light_count;
-
-struct Sky {
-    vec3 top, middle, bottom;
+// The lights of the frame where the positions & directions are in world space (5 texels per light, see LightData in "forward-renderer.hpp")
+// The first "cluster_count.w" lights are global (they light every fragment) and the rest are only read through the cluster lists
+uniform samplerBuffer light_data;
+// The (offset, count) of the light list of each cluster & the light lists (see LightClusters in "light-clusters.hpp")
+uniform usamplerBuffer light_clusters;
+uniform usamplerBuffer light_indices;
+
+Light fetch_light(int index){
+    vec4 texel0 = texelFetch(light_data, 5 * index);
+    vec4 texel1 = texelFetch(light_data, 5 * index + 1);
+    vec4 texel2 = texelFetch(light_data, 5 * index + 2);
+    vec4 texel3 = texelFetch(light_data, 5 * index + 3);
+    vec4 texel4 = texelFetch(light_data, 5 * index + 4);
+    Light light;
+    light.position = texel0.xyz;
+    light.type = int(texel0.w);
+    light.direction = texel1.xyz;
+    light.diffuse = texel2.xyz;
+    light.specular = texel3.xyz;
+    light.attenuation = texel4.xyz;
+    light.cone_angles = vec2(texel2.w, texel3.w);
+    return light;
+}
+
+// The camera, sky & light cluster data shared by all the draws of a frame (see FrameData in "forward-renderer.hpp")
+layout(std140) uniform FrameData {
+    mat4 VP;
+    vec4 eye;
+    vec4 sky_top;
+    vec4 sky_middle;
+    vec4 sky_bottom;
+    vec4 view_depth;
+    vec4 cluster_scale;
+    ivec4 cluster_count;
 };
 
-uniform Sky sky;
-
 struct Material {
     sampler2D albedo;
     sampler2D specular;
@@ -46,6 +71,11 @@ in Varyings {
 out vec4 frag_color;
 
 void main(){
+#ifdef DEPTH_ONLY
+    // The depth prepass only writes the depth so the shading is skipped
+    return;
+#endif
+
     //? Normalize the view direction and vertex normal
 
     vec3 view = normalize(fs_in.view);
@@ -64,19 +94,26 @@ void main(){
     //? Compute the sky light based on the vertex normal
 
     vec3 sky_light = (normal.y > 0) ?
-        mix(sky.middle, sky.top, normal.y * normal.y) :
-        mix(sky.middle, sky.bottom, normal.y * normal.y);
+        mix(sky_middle.rgb, sky_top.rgb, normal.y * normal.y) :
+        mix(sky_middle.rgb, sky_bottom.rgb, normal.y * normal.y);
     //? Initialize the fragment color with emissive and ambient components
 
     frag_color = vec4(material_emissive + material_ambient  , 1.0);
-    //? Clamp the number of lights to the maximum defined
 
-    int clamped_light_count = min(MAX_LIGHTS, light_count);
-    
-    //? Clamp the number of lights to the maximum defined
+    //? Find the cluster of the fragment from its screen position & its view depth
+
+    ivec2 tile = min(ivec2(gl_FragCoord.xy * cluster_scale.xy), cluster_count.xy - 1);
+    float depth = max(dot(view_depth, vec4(fs_in.world, 1.0)), 1e-4);
+    int slice = clamp(int(log(depth) * cluster_scale.z + cluster_scale.w), 0, cluster_count.z - 1);
+    uvec2 cluster = texelFetch(light_clusters, tile.x + cluster_count.x * (tile.y + cluster_count.y * slice)).xy;
+
+    //? Loop over the global lights then over the lights of the cluster
+    //? (the cluster lists index the local lights which are stored after the global lights in the light data)
 
-    for(int i = 0; i < clamped_light_count; i++){
-        Light light = lights[i];
+    int light_count = cluster_count.w + int(cluster.y);
+    for(int i = 0; i < light_count; i++){
+        int light_index = i < cluster_count.w ? i : cluster_count.w + int(texelFetch(light_indices, int(cluster.x) + i - cluster_count.w).r);
+        Light light = fetch_light(light_index);
 
         vec3 direction_to_light = -light.direction;
         if(light.type != DIRECTIONAL){
@@ -1,15 +1,43 @@
 #version 330
 
-uniform vec3 eye;
-uniform mat4 VP;
+// The camera, sky & light cluster data shared by all the draws of a frame (see FrameData in "forward-renderer.hpp")
+layout(std140) uniform FrameData {
+    mat4 VP;
+    vec4 eye;
+    vec4 sky_top;
+    vec4 sky_middle;
+    vec4 sky_bottom;
+    vec4 view_depth;
+    vec4 cluster_scale;
+    ivec4 cluster_count;
+};
+
+#ifdef INSTANCED
+// In the instanced variant, each instance brings its model matrix and its inverse transpose
+layout(location = 4) in mat4 instance_M;
+layout(location = 8) in mat4 instance_M_IT;
+#define M instance_M
+#define M_IT instance_M_IT
+#else
 uniform mat4 M;
 uniform mat4 M_IT;
+#endif
+
+#ifdef QUANTIZED
+// In the quantized variant, the positions are stored normalized in the bounding box of the mesh (see VertexFormat)
+uniform vec3 quantization_scale;
+uniform vec3 quantization_offset;
+#endif
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec4 color;
 layout(location = 2) in vec2 tex_coord;
 layout(location = 3) in vec3 normal;
 
+// The depth prepass draws with the DEPTH_ONLY variant of this shader then the shading pass tests the depth with GL_EQUAL,
+// so both variants must compute exactly the same positions
+invariant gl_Position;
+
 out Varyings {
     vec4 color;
     vec2 tex_coord;
@@ -19,6 +47,9 @@ out Varyings {
 } vs_out;
 
 void main() {
+#ifdef QUANTIZED
+    vec3 position = position * quantization_scale + quantization_offset;
+#endif
     //? Transform the vertex position from model space to world space
     vec3 world = (M * vec4(position, 1.0)).xyz;
 
@@ -33,7 +64,7 @@ void main() {
     vs_out.normal = normalize((M_IT * vec4(normal, 0.0)).xyz);
 
     //? Compute the view direction from the vertex to the camera eye position
-    vs_out.view = eye - world;
+    vs_out.view = eye.xyz - world;
 
     //? Pass the world space position to the fragment shader
     vs_out.world = world;
@@ -0,0 +1,5 @@
+#version 330 core
+
+// The proxies only count the samples passing the depth test (nothing is written)
+void main(){
+}
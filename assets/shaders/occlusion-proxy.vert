@@ -0,0 +1,11 @@
+#version 330 core
+
+// Maps the unit cube to the bounding box of the tested object (the box is inflated a bit so it is never hidden by the object itself)
+uniform mat4 transform;
+
+void main(){
+    // The 14 vertices of a triangle strip covering the 6 faces of the unit cube (the bits of each mask are the x, y & z of the vertices)
+    int bit = 1 << gl_VertexID;
+    vec3 position = vec3((0x287a & bit) != 0, (0x02af & bit) != 0, (0x31e3 & bit) != 0);
+    gl_Position = transform * vec4(position, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330
+
+// Resolves the weighted blended order-independent transparency over the opaque scene.
+// "accum" holds the weighted premultiplied colors (rgb) & the product of (1 - alpha) of the transparent fragments (a: the revealage)
+// and "weights" holds the sum of their weights. The result is blended with GL_SRC_ALPHA & GL_ONE_MINUS_SRC_ALPHA.
+
+out vec4 frag_color;
+
+uniform sampler2D accum;
+uniform sampler2D weights;
+
+void main(){
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 accumulated = texelFetch(accum, pixel, 0);
+    float revealage = accumulated.a;
+    // No transparent fragment covers this pixel
+    if(revealage >= 1.0) discard;
+    float weight = texelFetch(weights, pixel, 0).r;
+    frag_color = vec4(accumulated.rgb / max(weight, 1e-5), 1.0 - revealage);
+}
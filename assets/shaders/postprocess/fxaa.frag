@@ -0,0 +1,105 @@
+#version 330
+
+// The scene color with its luma in the alpha (see "luma.frag")
+uniform sampler2D tex;
+
+// The quality preset (see "fxaa" in the postprocess config of the renderer):
+// the local contrast needed to process a pixel (relative to its brightest neighbor & absolute for the dark pixels),
+// the amount of subpixel aliasing removal and the number of steps of the search for the ends of an edge
+uniform float edge_threshold = 0.166;
+uniform float edge_threshold_min = 0.0625;
+uniform float subpixel = 0.75;
+uniform float search_steps = 8.0;
+
+// Read "assets/shaders/fullscreen.vert" to know what "tex_coord" holds;
+in vec2 tex_coord;
+out vec4 frag_color;
+
+#define MAX_SEARCH_STEPS 16
+
+float luma_at(vec2 uv){
+    return textureLod(tex, uv, 0.0).a;
+}
+
+// Fast approximate anti-aliasing (after FXAA 3.11 by Timothy Lottes): the edges are detected from the luma contrast of each pixel,
+// then the pixel is blended with its neighbor across the edge according to its distance to the ends of the edge.
+void main(){
+    vec2 texel = 1.0 / vec2(textureSize(tex, 0));
+    vec4 center = textureLod(tex, tex_coord, 0.0);
+    float luma_m = center.a;
+    float luma_n = luma_at(tex_coord + vec2(0.0, texel.y));
+    float luma_s = luma_at(tex_coord - vec2(0.0, texel.y));
+    float luma_e = luma_at(tex_coord + vec2(texel.x, 0.0));
+    float luma_w = luma_at(tex_coord - vec2(texel.x, 0.0));
+
+    // The pixels with a low contrast are not on an edge
+    float luma_max = max(luma_m, max(max(luma_n, luma_s), max(luma_e, luma_w)));
+    float luma_min = min(luma_m, min(min(luma_n, luma_s), min(luma_e, luma_w)));
+    float range = luma_max - luma_min;
+    if(range < max(edge_threshold_min, luma_max * edge_threshold)){
+        frag_color = vec4(center.rgb, 1.0);
+        return;
+    }
+
+    float luma_ne = luma_at(tex_coord + texel);
+    float luma_sw = luma_at(tex_coord - texel);
+    float luma_nw = luma_at(tex_coord + vec2(-texel.x, texel.y));
+    float luma_se = luma_at(tex_coord + vec2(texel.x, -texel.y));
+
+    // The edge is horizontal if the luma changes more vertically than horizontally
+    float luma_ns = luma_n + luma_s, luma_we = luma_w + luma_e;
+    float edge_horizontal = abs(luma_nw + luma_sw - 2.0 * luma_w) + 2.0 * abs(luma_ns - 2.0 * luma_m) + abs(luma_ne + luma_se - 2.0 * luma_e);
+    float edge_vertical = abs(luma_nw + luma_ne - 2.0 * luma_n) + 2.0 * abs(luma_we - 2.0 * luma_m) + abs(luma_sw + luma_se - 2.0 * luma_s);
+    bool horizontal = edge_horizontal >= edge_vertical;
+
+    // Pick the side of the edge with the steepest gradient
+    float luma_1 = horizontal ? luma_s : luma_w;
+    float luma_2 = horizontal ? luma_n : luma_e;
+    float gradient_1 = luma_1 - luma_m, gradient_2 = luma_2 - luma_m;
+    bool steepest_1 = abs(gradient_1) >= abs(gradient_2);
+    float gradient_scaled = 0.25 * max(abs(gradient_1), abs(gradient_2));
+    float step_length = horizontal ? texel.y : texel.x;
+    float luma_local_average = 0.5 * ((steepest_1 ? luma_1 : luma_2) + luma_m);
+    if(steepest_1) step_length = -step_length;
+
+    // Walk along the edge (half a pixel towards the steepest side) in both directions until the luma leaves the edge
+    vec2 edge_uv = tex_coord + (horizontal ? vec2(0.0, 0.5 * step_length) : vec2(0.5 * step_length, 0.0));
+    vec2 offset = horizontal ? vec2(texel.x, 0.0) : vec2(0.0, texel.y);
+    vec2 uv_1 = edge_uv - offset, uv_2 = edge_uv + offset;
+    float luma_end_1 = luma_at(uv_1) - luma_local_average;
+    float luma_end_2 = luma_at(uv_2) - luma_local_average;
+    bool reached_1 = abs(luma_end_1) >= gradient_scaled;
+    bool reached_2 = abs(luma_end_2) >= gradient_scaled;
+    for(int i = 1; i < MAX_SEARCH_STEPS && float(i) < search_steps && !(reached_1 && reached_2); i++){
+        // The later steps are longer (the long edges need less precision)
+        float stride = i < 4 ? 1.0 : 2.0;
+        if(!reached_1){
+            uv_1 -= offset * stride;
+            luma_end_1 = luma_at(uv_1) - luma_local_average;
+            reached_1 = abs(luma_end_1) >= gradient_scaled;
+        }
+        if(!reached_2){
+            uv_2 += offset * stride;
+            luma_end_2 = luma_at(uv_2) - luma_local_average;
+            reached_2 = abs(luma_end_2) >= gradient_scaled;
+        }
+    }
+
+    // The closer the pixel is to an end of the edge, the more it is blended (if the luma at that end varies the right way)
+    float distance_1 = horizontal ? tex_coord.x - uv_1.x : tex_coord.y - uv_1.y;
+    float distance_2 = horizontal ? uv_2.x - tex_coord.x : uv_2.y - tex_coord.y;
+    bool closer_1 = distance_1 < distance_2;
+    float edge_offset = 0.5 - min(distance_1, distance_2) / (distance_1 + distance_2);
+    bool center_smaller = luma_m < luma_local_average;
+    bool correct_variation = ((closer_1 ? luma_end_1 : luma_end_2) < 0.0) != center_smaller;
+    float final_offset = correct_variation ? edge_offset : 0.0;
+
+    // The subpixel aliasing (e.g. thin lines) is removed by blending with the average luma of the 3x3 neighborhood
+    float luma_average = (2.0 * (luma_ns + luma_we) + luma_nw + luma_ne + luma_sw + luma_se) / 12.0;
+    float subpixel_offset = clamp(abs(luma_average - luma_m) / range, 0.0, 1.0);
+    subpixel_offset = (-2.0 * subpixel_offset + 3.0) * subpixel_offset * subpixel_offset;
+    final_offset = max(final_offset, subpixel_offset * subpixel_offset * subpixel);
+
+    vec2 final_uv = tex_coord + (horizontal ? vec2(0.0, final_offset * step_length) : vec2(final_offset * step_length, 0.0));
+    frag_color = vec4(textureLod(tex, final_uv, 0.0).rgb, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 330
+
+// The texture holding the scene pixels
+uniform sampler2D tex;
+
+// Read "assets/shaders/fullscreen.vert" to know what "tex_coord" holds;
+in vec2 tex_coord;
+out vec4 frag_color;
+
+// Stores the luma of each pixel in its alpha so the FXAA pass (see "fxaa.frag") reads it with the color instead of computing it
+// for each of the many neighbors it samples
+void main(){
+    vec3 color = texture(tex, tex_coord).rgb;
+    frag_color = vec4(color, dot(color, vec3(0.299, 0.587, 0.114)));
+}
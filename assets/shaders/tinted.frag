@@ -4,7 +4,14 @@ in Varyings {
     vec4 color;
 } fs_in;
 
+#ifdef OIT
+// Weighted blended order-independent transparency: the color is accumulated in the targets of the OIT pass (see ForwardRenderer)
+layout(location = 0) out vec4 oit_accum;
+layout(location = 1) out float oit_weight;
+vec4 frag_color;
+#else
 out vec4 frag_color;
+#endif
 
 uniform vec4 tint;
 
@@ -12,4 +19,11 @@ void main(){
     //DONE: (Req 7) Modify the following line to compute the fragment color
     // by multiplying the tint with the vertex color
     frag_color = tint * fs_in.color;
+
+#ifdef OIT
+    // The weight favors the closer fragments (McGuire & Bavoil 2013). The revealage is accumulated in the alpha of the first target.
+    float weight = frag_color.a * clamp(3e3 * pow(1.0 - gl_FragCoord.z, 3.0), 1e-2, 3e3);
+    oit_accum = vec4(frag_color.rgb * weight, frag_color.a);
+    oit_weight = weight;
+#endif
 }
\ No newline at end of file
@@ -9,8 +9,26 @@ out Varyings {
 
 uniform mat4 transform;
 
+#ifdef INSTANCED
+// In the instanced variant, "transform" only holds the view-projection matrix and each instance brings its model matrix
+layout(location = 4) in mat4 instance_M;
+#endif
+
+#ifdef QUANTIZED
+// In the quantized variant, the positions are stored normalized in the bounding box of the mesh (see VertexFormat)
+uniform vec3 quantization_scale;
+uniform vec3 quantization_offset;
+#endif
+
 void main(){
+#ifdef QUANTIZED
+    vec3 position = position * quantization_scale + quantization_offset;
+#endif
     //DONE: (Req 7) Change the next line to apply the transformation matrix
+#ifdef INSTANCED
+    gl_Position = transform * instance_M * vec4(position, 1.0);
+#else
     gl_Position = transform * vec4(position, 1.0);
+#endif
     vs_out.color = color;
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+param([string[]] $tests = @("renderer-test", "sky-test", "postprocess-test"))
+
+# Runs every config of the given tests in the benchmark mode (using the default settings & budgets of "frame-benchmark.hpp"
+# overridden by the "benchmark" block of the config if any)
+# The reports are written to "benchmarks/<test>/" and the exit code is the number of configs that exceeded their budgets
+$failure = 0
+foreach ($test in $tests){
+    Write-Output ""
+    Write-Output "Benchmarking ${test}:"
+    Write-Output ""
+    foreach ($config in Get-ChildItem "config/$test" -Filter *.jsonc){
+        ./bin/GAME_APPLICATION -bench -c="config/$test/$($config.Name)"
+        if ($LASTEXITCODE -ne 0) { $failure += 1 }
+    }
+}
+exit $failure
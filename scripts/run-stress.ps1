@@ -0,0 +1,9 @@
+param([int[]] $counts = @(1000, 10000, 100000), [int] $frames = 300)
+
+# Runs the generated stress scene at each entity count and prints the frame time percentiles & render statistics of each run
+foreach ($count in $counts){
+    Write-Output ""
+    Write-Output "Running stress scene with $count entities:"
+    Write-Output ""
+    ./bin/GAME_APPLICATION -c="config/game.jsonc" -stress="$count" -f="$frames"
+}
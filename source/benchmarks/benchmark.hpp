@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <json/json.hpp>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace our::benchmark
+{
+
+    // The result of a single benchmark. All the times are in nanoseconds per iteration.
+    struct Result
+    {
+        std::string name;
+        size_t iterations = 0;
+        double mean = 0, median = 0, min = 0, max = 0, stddev = 0;
+    };
+
+    inline void to_json(nlohmann::json &j, const Result &result)
+    {
+        j = nlohmann::json{
+            {"name", result.name},
+            {"iterations", result.iterations},
+            {"mean_ns", result.mean},
+            {"median_ns", result.median},
+            {"min_ns", result.min},
+            {"max_ns", result.max},
+            {"stddev_ns", result.stddev}};
+    }
+
+    // Prevents the compiler from optimizing away a value computed inside a benchmark body.
+    // The empty asm statement claims to read the value's memory (and to clobber all memory) so the value must really be computed & stored.
+    template <typename T>
+    inline void doNotOptimize(const T &value)
+    {
+#if defined(_MSC_VER)
+        // MSVC has no inline asm on x64: the value is read back through a volatile pointer instead
+        static const volatile char *sink;
+        sink = reinterpret_cast<const volatile char *>(&value);
+        (void)*sink;
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "g"(&value) : "memory");
+#endif
+    }
+
+    // Runs "body" repeatedly and returns the time statistics per iteration.
+    // Very cheap bodies are timed in batches (so the timer resolution does not dominate) and the batch time is divided by the batch size.
+    // The benchmark stops when it ran for at least "minSeconds" and at least "minSamples" batches were timed.
+    inline Result run(const std::string &name, const std::function<void()> &body, double minSeconds = 0.25, size_t minSamples = 10)
+    {
+        using clock = std::chrono::steady_clock;
+        auto elapsed = [](clock::time_point start)
+        { return std::chrono::duration<double, std::nano>(clock::now() - start).count(); };
+
+        // Warm up once and pick a batch size such that each sample takes at least 10 microseconds
+        auto start = clock::now();
+        body();
+        double single = std::max(elapsed(start), 1.0);
+        size_t batch = std::max<size_t>(1, (size_t)(10000.0 / single));
+
+        std::vector<double> samples;
+        double total = 0;
+        while (total < minSeconds * 1e9 || samples.size() < minSamples)
+        {
+            start = clock::now();
+            for (size_t i = 0; i < batch; i++)
+                body();
+            double time = elapsed(start);
+            total += time;
+            samples.push_back(time / batch);
+        }
+
+        Result result;
+        result.name = name;
+        result.iterations = samples.size() * batch;
+        std::sort(samples.begin(), samples.end());
+        result.min = samples.front();
+        result.max = samples.back();
+        result.median = samples[samples.size() / 2];
+        for (double sample : samples)
+            result.mean += sample;
+        result.mean /= samples.size();
+        for (double sample : samples)
+            result.stddev += (sample - result.mean) * (sample - result.mean);
+        result.stddev = std::sqrt(result.stddev / samples.size());
+        return result;
+    }
+
+}
@@ -0,0 +1,253 @@
+#include <iostream>
+#include <fstream>
+#include <flags/flags.h>
+#include <json/json.hpp>
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#include <asset-loader.hpp>
+#include <ecs/world.hpp>
+#include <components/camera.hpp>
+#include <components/light.hpp>
+#include <components/mesh-renderer.hpp>
+#include <components/movement.hpp>
+#include <mesh/mesh-utils.hpp>
+#include <mesh/mesh-optimize.hpp>
+#include <texture/texture-utils.hpp>
+#include <systems/forward-renderer.hpp>
+#include <systems/render-sort.hpp>
+#include <systems/light-clusters.hpp>
+
+#include <array>
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmark.hpp"
+
+// This executable measures the hot paths of the engine and prints the results as json so they can be tracked over time.
+// It creates a hidden window since loading meshes & textures and rendering a frame need an OpenGL context.
+// Options:
+//  -c      the config whose assets, levels & renderer are benchmarked (Default: "config/game.jsonc")
+//  -o      a file to which the json results are written (Default: "" where the results are only printed)
+//  -filter only run the benchmarks whose name contains this string (Default: "" which runs everything)
+//  -t      the minimum number of seconds spent on each benchmark (Default: 0.25)
+int main(int argc, char **argv)
+{
+    flags::args args(argc, argv);
+    std::string config_path = args.get<std::string>("c", "config/game.jsonc");
+    std::string output_path = args.get<std::string>("o", "");
+    std::string filter = args.get<std::string>("filter", "");
+    double min_seconds = args.get<double>("t", 0.25);
+
+    std::ifstream file_in(config_path);
+    if (!file_in)
+    {
+        std::cerr << "Couldn't open file: " << config_path << std::endl;
+        return -1;
+    }
+    nlohmann::json app_config = nlohmann::json::parse(file_in, nullptr, true, true);
+    file_in.close();
+    auto &scene = app_config["scene"];
+
+    // Create a hidden window to get an OpenGL 3.3 context
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to Initialize GLFW" << std::endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glm::ivec2 window_size = {
+        app_config["window"]["size"].value("width", 1280),
+        app_config["window"]["size"].value("height", 720)};
+    GLFWwindow *window = glfwCreateWindow(window_size.x, window_size.y, "Benchmarks", nullptr, nullptr);
+    if (!window)
+    {
+        std::cerr << "Failed to Create Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    gladLoadGL(glfwGetProcAddress);
+    std::string gl_renderer = (const char *)glGetString(GL_RENDERER);
+
+    std::vector<our::benchmark::Result> results;
+    // The quality measures reported with the timings (e.g. the ACMR before & after the mesh optimization)
+    nlohmann::json metrics = nlohmann::json::object();
+    auto bench = [&](const std::string &name, const std::function<void()> &body)
+    {
+        if (name.find(filter) == std::string::npos)
+            return;
+        results.push_back(our::benchmark::run(name, body, min_seconds));
+        const auto &result = results.back();
+        std::cerr << name << ": " << result.median << " ns (median of " << result.iterations << " iterations)" << std::endl;
+    };
+
+    // ECS: component lookup on an entity holding the same components as a lit car
+    {
+        our::World world;
+        our::Entity *entity = world.add();
+        entity->parent = nullptr;
+        entity->addComponent<our::MovementComponent>();
+        entity->addComponent<our::LightComponent>();
+        entity->addComponent<our::MeshRendererComponent>();
+        bench("ecs/get-component/first", [&]()
+              { our::benchmark::doNotOptimize(entity->getComponent<our::MovementComponent>()); });
+        bench("ecs/get-component/last", [&]()
+              { our::benchmark::doNotOptimize(entity->getComponent<our::MeshRendererComponent>()); });
+        bench("ecs/get-component/missing", [&]()
+              { our::benchmark::doNotOptimize(entity->getComponent<our::CameraComponent>()); });
+    }
+
+    // ECS: local to world matrix of the leaf of a chain of entities
+    for (int depth : {1, 4, 16, 64})
+    {
+        our::World world;
+        our::Entity *leaf = nullptr;
+        for (int level = 0; level < depth; level++)
+        {
+            our::Entity *entity = world.add();
+            entity->parent = leaf;
+            entity->localTransform.position = {1, 2, 3};
+            entity->localTransform.rotation = {0.1f, 0.2f, 0.3f};
+            leaf = entity;
+        }
+        bench("ecs/local-to-world/depth-" + std::to_string(depth), [&]()
+              { our::benchmark::doNotOptimize(leaf->getLocalToWorldMatrix()); });
+    }
+
+    // Render command sorting: the radix sort against a comparison sort on random keys
+    for (size_t count : {1000, 10000, 50000})
+    {
+        std::mt19937_64 generator(count);
+        std::vector<our::render_sort::Entry> keys(count), entries, scratch;
+        for (size_t i = 0; i < count; i++)
+            keys[i] = {generator(), (uint32_t)i};
+        bench("render-sort/radix/" + std::to_string(count), [&]()
+              {
+            entries = keys;
+            our::render_sort::radixSort(entries, scratch);
+            our::benchmark::doNotOptimize(entries.front()); });
+        bench("render-sort/std-sort/" + std::to_string(count), [&]()
+              {
+            entries = keys;
+            std::sort(entries.begin(), entries.end(), [](const auto &first, const auto &second)
+                      { return first.key < second.key; });
+            our::benchmark::doNotOptimize(entries.front()); });
+    }
+
+    // Clustered lighting: binning random point lights around the origin into the clusters of a camera looking at it
+    for (size_t count : {64, 256, 1024})
+    {
+        std::mt19937 generator(count);
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f), radius(0.5f, 6.0f);
+        std::vector<glm::vec4> lights(count);
+        for (auto &light : lights)
+            light = {position(generator), 1.0f, position(generator), radius(generator)};
+        glm::mat4 V = glm::lookAt(glm::vec3(0, 10, 40), glm::vec3(0), glm::vec3(0, 1, 0));
+        glm::mat4 P = glm::perspective(glm::radians(60.0f), (float)window_size.x / window_size.y, 0.1f, 200.0f);
+        our::LightClusters clusters;
+        bench("light-clusters/build/" + std::to_string(count), [&]()
+              {
+            clusters.build(lights, V, P, true, 0.1f, 200.0f, 1 << 24);
+            our::benchmark::doNotOptimize(clusters.getIndices().size()); });
+    }
+
+    // Asset loading
+    bench("mesh/load-obj/car", []()
+          { delete our::mesh_utils::loadOBJ("assets/models/car.obj"); });
+    bench("mesh/load-obj/car-with-lods", []()
+          { delete our::mesh_utils::loadOBJ("assets/models/car.obj", {{0.5f, 0.25f}, {0.25f, 0.1f}, {0.1f, 0.04f}}); });
+    bench("mesh/load-obj/car-optimized", []()
+          { delete our::mesh_utils::loadOBJ("assets/models/car.obj", {}, our::VertexFormat::FLOAT, false, true); });
+    {
+        // The vertex cache optimization alone on a 128x128 grid whose triangles are shuffled (the passes work in place so each iteration copies)
+        const int size = 128;
+        std::vector<std::array<GLuint, 3>> triangles;
+        for (int y = 0; y < size; y++)
+            for (int x = 0; x < size; x++)
+            {
+                GLuint corner = y * (size + 1) + x;
+                triangles.push_back({corner, corner + 1, corner + size + 2});
+                triangles.push_back({corner, corner + size + 2, corner + size + 1});
+            }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(size));
+        std::vector<GLuint> gridElements;
+        for (auto &triangle : triangles)
+            gridElements.insert(gridElements.end(), triangle.begin(), triangle.end());
+        bench("mesh/optimize-vertex-cache/grid-128", [&]()
+              {
+            auto elements = gridElements;
+            our::mesh_utils::optimizeVertexCache(elements, (size + 1) * (size + 1));
+            our::benchmark::doNotOptimize(elements.front()); });
+
+        // The average cache miss ratio (transformed vertices per triangle) of the grid before & after the optimization
+        auto optimized = gridElements;
+        our::mesh_utils::optimizeVertexCache(optimized, (size + 1) * (size + 1));
+        float acmrBefore = our::mesh_utils::computeACMR(gridElements, (size + 1) * (size + 1));
+        float acmrAfter = our::mesh_utils::computeACMR(optimized, (size + 1) * (size + 1));
+        metrics["mesh/acmr/grid-128"] = {{"before", acmrBefore}, {"after", acmrAfter}};
+        std::cerr << "mesh/acmr/grid-128: " << acmrBefore << " -> " << acmrAfter << std::endl;
+    }
+    bench("texture/load-image/car", []()
+          { delete our::texture_utils::loadImage("assets/textures/car.jpg"); });
+
+    // The levels need the assets to be loaded since the mesh renderers look them up by name
+    if (scene.contains("assets"))
+        our::deserializeAllAssets(scene["assets"]);
+
+    std::vector<std::string> levels;
+    for (auto &[key, value] : scene.items())
+        if (key.rfind("world", 0) == 0)
+            levels.push_back(key);
+
+    for (auto &level : levels)
+    {
+        bench("world/deserialize/" + level, [&]()
+              {
+            our::World world;
+            world.deserialize(scene[level]); });
+    }
+
+    // Rendering: command collection & sorting then a full frame (waiting for the GPU to finish)
+    for (auto &level : levels)
+    {
+        our::World world;
+        world.deserialize(scene[level]);
+        our::ForwardRenderer renderer;
+        renderer.initialize(window_size, scene["renderer"]);
+        bench("renderer/collect-commands/" + level, [&]()
+              { our::benchmark::doNotOptimize(renderer.collectCommands(&world)); });
+        bench("renderer/frame/" + level, [&]()
+              {
+            renderer.render(&world);
+            glFinish(); });
+        renderer.destroy();
+    }
+
+    our::clearAllAssets();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    nlohmann::json output = {
+        {"config", config_path},
+        {"renderer", gl_renderer},
+        {"benchmarks", results},
+        {"metrics", metrics}};
+    std::cout << output.dump(2) << std::endl;
+    if (!output_path.empty())
+    {
+        std::ofstream file_out(output_path);
+        if (!file_out)
+        {
+            std::cerr << "Couldn't open file: " << output_path << std::endl;
+            return -1;
+        }
+        file_out << output.dump(2) << std::endl;
+    }
+    return 0;
+}
@@ -24,6 +24,10 @@
 #endif
 
 #include "texture/screenshot.hpp"
+#include "render-stats.hpp"
+#include "gl-state.hpp"
+#include "frame-benchmark.hpp"
+#include "gpu-pass-timers.hpp"
 
 std::string default_screenshot_filepath()
 {
@@ -179,6 +183,16 @@ our::WindowConfiguration our::Application::getWindowConfiguration()
 // if run_for_frames == 0, the application runs indefinitely till manually closed.
 int our::Application::run(int run_for_frames)
 {
+    // In the benchmark mode, "run_for_frames" is the number of measured frames and the warm-up frames are drawn before them
+    BenchmarkSettings benchmark;
+    if (app_config.contains("benchmark"))
+        benchmark.deserialize(app_config["benchmark"]);
+    if (benchmark.enabled)
+    {
+        if (run_for_frames != 0)
+            benchmark.frames = run_for_frames;
+        run_for_frames = benchmark.warmup + benchmark.frames;
+    }
 
     // Set the function to call when an error occurs.
     glfwSetErrorCallback(glfw_error_callback);
@@ -208,6 +222,11 @@ int our::Application::run(int run_for_frames)
     glfwMakeContextCurrent(window); // Tell GLFW to make the context of our window the main context on the current thread.
 
     gladLoadGL(glfwGetProcAddress); // Load the OpenGL functions from the driver
+    GLState::invalidate();          // The mirrored state may belong to the context of a previous run
+
+    // In the benchmark mode, we choose whether the swap waits for the vertical sync (otherwise, we keep the driver default)
+    if (benchmark.enabled)
+        glfwSwapInterval(benchmark.vsync ? 1 : 0);
 
     // Print information about the OpenGL context
     std::cout << "VENDOR          : " << glGetString(GL_VENDOR) << std::endl;
@@ -269,6 +288,16 @@ int our::Application::run(int run_for_frames)
         }
     }
 
+    // The render statistics window can be shown from the start using the option "show-render-stats" in the config
+    // It can also be toggled at any time by pressing F3
+    bool showRenderStats = app_config.value("show-render-stats", false);
+    RenderStats::reset();
+    GPUPassTimers::reset();
+    frameTimings.clear();
+    // In the benchmark mode, we also split each frame into the CPU time (till the swap) and the GPU time (measured by timer queries)
+    FrameTimings cpuTimings, gpuTimings;
+    GPUTimer gpuTimer;
+
     // If a scene change was requested, apply it
     if (nextState)
     {
@@ -291,6 +320,17 @@ int our::Application::run(int run_for_frames)
             break;
         glfwPollEvents(); // Read all the user events and call relevant callbacks.
 
+        // The warm-up frames are excluded from all the measurements
+        bool measured = !benchmark.enabled || current_frame >= benchmark.warmup;
+        if (benchmark.enabled && current_frame == benchmark.warmup)
+        {
+            RenderStats::reset();
+            GPUPassTimers::reset();
+        }
+        double cpu_start_time = glfwGetTime();
+        if (benchmark.enabled)
+            gpuTimer.begin();
+
         // Start a new ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -402,6 +442,14 @@ int our::Application::run(int run_for_frames)
             ImGui::End();
         }
 
+        if (keyboard.justPressed(GLFW_KEY_F3))
+            showRenderStats = !showRenderStats;
+        if (showRenderStats)
+        {
+            RenderStats::drawImGui();
+            GPUPassTimers::drawImGui();
+        }
+
         // If ImGui is using the mouse or keyboard, then we don't want the captured events to affect our keyboard and mouse objects.
         // For example, if you're focusing on an input and writing "W", the keyboard object shouldn't record this event.
         keyboard.setEnabled(!io.WantCaptureKeyboard, window);
@@ -419,8 +467,13 @@ int our::Application::run(int run_for_frames)
         double current_frame_time = glfwGetTime();
 
         // Call onDraw, in which we will draw the current frame, and send to it the time difference between the last and current frame
+        // In the benchmark mode, the states can be given a fixed delta time so every run simulates the same thing
+        double delta_time = benchmark.enabled && benchmark.fixedDelta > 0 ? benchmark.fixedDelta : current_frame_time - last_frame_time;
         if (currentState)
-            currentState->onDraw(current_frame_time - last_frame_time);
+            currentState->onDraw(delta_time);
+        // The first frame has no previous frame so its delta time only measures the initialization
+        if (current_frame > 0 && measured)
+            frameTimings.record((current_frame_time - last_frame_time) * 1000.0);
         last_frame_time = current_frame_time; // Then update the last frame start time (this frame is now the last frame)
 
 #if defined(ENABLE_OPENGL_DEBUG_MESSAGES)
@@ -434,6 +487,8 @@ int our::Application::run(int run_for_frames)
         glEnable(GL_DEBUG_OUTPUT);
         glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 #endif
+        // ImGui changed the OpenGL state behind our back, so the next frame should not trust the mirrored state
+        GLState::invalidate();
 
         // If F12 is pressed, take a screenshot
         if (keyboard.justPressed(GLFW_KEY_F12))
@@ -468,9 +523,22 @@ int our::Application::run(int run_for_frames)
                 break;
         }
 
+        if (benchmark.enabled)
+        {
+            gpuTimer.end(measured);
+            if (measured)
+                cpuTimings.record((glfwGetTime() - cpu_start_time) * 1000.0);
+        }
+
         // Swap the frame buffers
         glfwSwapBuffers(window);
 
+        if (benchmark.enabled)
+            gpuTimer.collect(gpuTimings);
+
+        // Archive the render statistics of this frame
+        RenderStats::endFrame();
+
         // Update the keyboard and mouse data
         keyboard.update();
         mouse.update();
@@ -491,6 +559,52 @@ int our::Application::run(int run_for_frames)
         ++current_frame;
     }
 
+    // If we ran for a fixed number of frames, print what these frames cost
+    if (run_for_frames != 0)
+    {
+        RenderStats::printSummary(std::cout);
+        frameTimings.printSummary(std::cout);
+        GPUPassTimers::printSummary(std::cout);
+    }
+
+    // In the benchmark mode, we report the measurements and check them against the budgets
+    int exit_code = 0;
+    if (benchmark.enabled)
+    {
+        gpuTimer.collect(gpuTimings, true);
+        gpuTimer.destroy();
+        cpuTimings.printSummary(std::cout, "CPU times");
+        gpuTimings.printSummary(std::cout, "GPU times");
+        double peak_memory = getPeakMemoryUsage() / (1024.0 * 1024.0);
+        std::cout << "Peak memory: " << peak_memory << " MB" << std::endl;
+
+        nlohmann::json report = {
+            {"renderer", (const char *)glGetString(GL_RENDERER)},
+            {"frames", frameTimings.count()},
+            {"warmup", benchmark.warmup},
+            {"fixed-delta", benchmark.fixedDelta},
+            {"vsync", benchmark.vsync},
+            {"frame", frameTimings.toJson()},
+            {"cpu", cpuTimings.toJson()},
+            {"gpu", gpuTimings.toJson()},
+            {"gpu-passes", GPUPassTimers::toJson()},
+            {"peak-memory-mb", peak_memory}};
+        if (!benchmark.output.empty())
+        {
+            auto directory = std::filesystem::path(benchmark.output).parent_path();
+            if (!directory.empty())
+                std::filesystem::create_directories(directory);
+            std::ofstream file_out(benchmark.output);
+            if (file_out)
+                file_out << report.dump(2) << std::endl;
+            else
+                std::cerr << "Couldn't open file: " << benchmark.output << std::endl;
+        }
+
+        if (checkBudgets(benchmark.budgets, report, std::cerr) > 0)
+            exit_code = 1;
+    }
+
     // Call for cleaning up
     if (currentState)
         currentState->onDestroy();
@@ -505,7 +619,7 @@ int our::Application::run(int run_for_frames)
 
     // And finally terminate GLFW
     glfwTerminate();
-    return 0; // Good bye
+    return exit_code; // Good bye
 }
 
 // Sets-up the window callback functions from GLFW to our (Mouse/Keyboard) classes.
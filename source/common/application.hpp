@@ -12,6 +12,7 @@
 
 #include "input/keyboard.hpp"
 #include "input/mouse.hpp"
+#include "frame-timings.hpp"
 #include <time.h>
 #include <iostream>
 #include <irrKlang.h>
@@ -92,6 +93,8 @@ namespace our
         State *currentState = nullptr;                   // This will store the current scene that is being run
         State *nextState = nullptr;                      // If it is requested to go to another scene, this will contain a pointer to that scene
 
+        FrameTimings frameTimings; // The duration of every frame drawn since the application started running
+
         // Virtual functions to be overrode and change the default behaviour of the application
         // according to the example needs.
         virtual void configureOpenGL();                       // This function sets OpenGL Window Hints in GLFW.
@@ -297,6 +300,7 @@ namespace our
         [[nodiscard]] const Mouse &getMouse() const { return mouse; }
 
         [[nodiscard]] const nlohmann::json &getConfig() const { return app_config; }
+        [[nodiscard]] const FrameTimings &getFrameTimings() const { return frameTimings; }
 
         // Get the size of the frame buffer of the window in pixels.
         glm::ivec2 getFrameBufferSize()
@@ -63,12 +63,24 @@ namespace our {
     // This will load all the meshes defined in "data"
     // data must be in the form:
     //    { mesh_name : "path/to/3d-model-file", ... }
+    // or, to generate simplified levels of detail (see MeshLOD):
+    //    { mesh_name : { "path" : "path/to/3d-model-file", "lods" : [ { "ratio" : 0.5, "screenSize" : 0.2 }, ... ] }, ... }
+    // where "format" can also be given to pick how the vertices are stored on the GPU: "float" (default), "packed" or "quantized" (see VertexFormat)
+    // and "optimize" can be set to true to reorder the triangles & the vertices for the GPU (Default: false which keeps the order of the file)
+    // All the meshes are allocated in the geometry arenas (see GeometryArena) so the draws of different meshes share the same vertex array
     template<>
     void AssetLoader<Mesh>::deserialize(const nlohmann::json& data) {
         if(data.is_object()){
             for(auto& [name, desc] : data.items()){
-                std::string path = desc.get<std::string>();
-                assets[name] = mesh_utils::loadOBJ(path);
+                if(desc.is_string()){
+                    assets[name] = mesh_utils::loadOBJ(desc.get<std::string>(), {}, VertexFormat::FLOAT, true);
+                    continue;
+                }
+                std::vector<mesh_utils::LODSettings> lods;
+                if(desc.contains("lods"))
+                    for(auto& lod : desc["lods"])
+                        lods.push_back({lod.value("ratio", 0.5f), lod.value("screenSize", 0.0f)});
+                assets[name] = mesh_utils::loadOBJ(desc.value("path", ""), lods, parseVertexFormat(desc.value("format", "float")), true, desc.value("optimize", false));
             }
         }
     };
@@ -116,6 +128,8 @@ namespace our {
         AssetLoader<Texture2D>::clear();
         AssetLoader<Sampler>::clear();
         AssetLoader<Mesh>::clear();
+        // The arenas are empty now that the meshes are deleted
+        GeometryArena::clear();
         AssetLoader<Material>::clear();
     }
 
@@ -0,0 +1,138 @@
+#include "frame-benchmark.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+void our::BenchmarkSettings::deserialize(const nlohmann::json &data)
+{
+    if (!data.is_object())
+        return;
+    enabled = data.value("enabled", enabled);
+    frames = data.value("frames", frames);
+    warmup = data.value("warmup", warmup);
+    fixedDelta = data.value("fixed-delta", fixedDelta);
+    vsync = data.value("vsync", vsync);
+    output = data.value("output", output);
+    if (data.contains("budgets"))
+        budgets.merge_patch(data["budgets"]);
+}
+
+void our::GPUTimer::begin()
+{
+    GLuint query;
+    if (available.empty())
+    {
+        glGenQueries(1, &query);
+    }
+    else
+    {
+        query = available.back();
+        available.pop_back();
+    }
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    pending.push_back({query, false});
+}
+
+void our::GPUTimer::end(bool record)
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    pending.back().second = record;
+}
+
+void our::GPUTimer::collect(FrameTimings &timings, bool wait)
+{
+    while (!pending.empty())
+    {
+        auto [query, record] = pending.front();
+        if (!wait)
+        {
+            GLint ready = GL_FALSE;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &ready);
+            // The queries finish in order so if this one is not ready, the following ones are not ready either
+            if (!ready)
+                break;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        if (record)
+            timings.record(nanoseconds / 1e6);
+        available.push_back(query);
+        pending.pop_front();
+    }
+}
+
+void our::GPUTimer::destroy()
+{
+    for (auto &[query, record] : pending)
+        available.push_back(query);
+    pending.clear();
+    if (!available.empty())
+        glDeleteQueries((GLsizei)available.size(), available.data());
+    available.clear();
+}
+
+size_t our::getPeakMemoryUsage()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return (size_t)usage.ru_maxrss; // In bytes on macOS
+#else
+    return (size_t)usage.ru_maxrss * 1024; // In kilobytes on Linux
+#endif
+#endif
+}
+
+int our::checkBudgets(const nlohmann::json &budgets, const nlohmann::json &report, std::ostream &stream)
+{
+    int exceeded = 0;
+    for (auto &[key, budget] : budgets.items())
+    {
+        if (!report.contains(key))
+        {
+            stream << "Unknown benchmark budget: " << key << std::endl;
+            continue;
+        }
+        const nlohmann::json &measured = report[key];
+        // A budget is either a single number (e.g. "peak-memory-mb") or a group of statistics (e.g. "frame": { "p95": 16.6 })
+        if (budget.is_number())
+        {
+            if (measured.is_number() && measured.get<double>() > budget.get<double>())
+            {
+                stream << "Budget exceeded: " << key << " = " << measured.get<double>() << " > " << budget.get<double>() << std::endl;
+                ++exceeded;
+            }
+        }
+        else if (budget.is_object())
+        {
+            for (auto &[statistic, limit] : budget.items())
+            {
+                if (!measured.contains(statistic))
+                {
+                    stream << "Unknown benchmark budget: " << key << "." << statistic << std::endl;
+                    continue;
+                }
+                double value = measured[statistic].get<double>();
+                if (value > limit.get<double>())
+                {
+                    stream << "Budget exceeded: " << key << "." << statistic << " = " << value << " ms > " << limit.get<double>() << " ms" << std::endl;
+                    ++exceeded;
+                }
+            }
+        }
+    }
+    return exceeded;
+}
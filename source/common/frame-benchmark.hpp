@@ -0,0 +1,65 @@
+#pragma once
+
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <json/json.hpp>
+
+#include "frame-timings.hpp"
+
+namespace our
+{
+
+    // The settings of the benchmark mode which are read from the "benchmark" block of the config.
+    // The block is optional: the defaults below are shared by all the configs, so a config only lists what differs
+    // (the budgets are merged key by key with the default budgets, and a null budget removes a default one).
+    // Example:
+    //  "benchmark": {
+    //      "enabled": true,        // Whether the benchmark mode is on (the "-bench" option turns it on)
+    //      "frames": 300,          // Number of measured frames (the "-f" option overrides it)
+    //      "warmup": 60,           // Number of frames drawn before the measurement starts
+    //      "fixed-delta": 0.016,   // The delta time (in seconds) sent to the states every frame (0 = use the real time)
+    //      "vsync": false,         // Whether the swap waits for the vertical sync
+    //      "output": "benchmarks/game.json", // A json file to which the report is written (Default: "" which only prints it, but "-bench" derives it from the config path)
+    //      "budgets": { "frame": { "p95": 16.6 }, "gpu": { "avg": 8 }, "peak-memory-mb": 512 }
+    //  }
+    struct BenchmarkSettings
+    {
+        bool enabled = false;
+        int frames = 300;
+        int warmup = 60;
+        double fixedDelta = 0.016;
+        bool vsync = false;
+        std::string output;
+        nlohmann::json budgets = {{"frame", {{"p95", 33.3}}}, {"peak-memory-mb", 512}};
+
+        void deserialize(const nlohmann::json &data);
+    };
+
+    // Measures the GPU time spent between "begin" and "end" using timer queries.
+    // The results are read a few frames later (when they are available) so the CPU never waits for the GPU.
+    class GPUTimer
+    {
+        std::vector<GLuint> available;
+        std::deque<std::pair<GLuint, bool>> pending; // The queries in flight and whether their result should be recorded
+
+    public:
+        void begin();
+        // Ends the current query. If "record" is false, the result is discarded (e.g. during the warm-up frames)
+        void end(bool record);
+        // Records the results of the finished queries into "timings". If "wait" is true, it waits for all the queries to finish
+        void collect(FrameTimings &timings, bool wait = false);
+        void destroy();
+    };
+
+    // Returns the peak memory used by the process in bytes (0 if it is not supported on this platform)
+    size_t getPeakMemoryUsage();
+
+    // Checks the report against the budgets in the settings and prints every budget that was exceeded.
+    // Returns the number of the exceeded budgets.
+    int checkBudgets(const nlohmann::json &budgets, const nlohmann::json &report, std::ostream &stream);
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <json/json.hpp>
+
+namespace our
+{
+
+    // This class records the duration of each frame (in milliseconds) and computes statistics over them
+    // The statistics are computed on demand so recording a frame is just a push into a vector
+    class FrameTimings
+    {
+        std::vector<double> samples;
+
+    public:
+        void clear() { samples.clear(); }
+        void record(double milliseconds) { samples.push_back(milliseconds); }
+        size_t count() const { return samples.size(); }
+
+        double average() const
+        {
+            if (samples.empty())
+                return 0;
+            double sum = 0;
+            for (double sample : samples)
+                sum += sample;
+            return sum / samples.size();
+        }
+
+        // Returns the smallest frame time such that at least "percent"% of the frames are at or below it
+        // (nearest rank: the ceil(percent / 100 * n)-th smallest sample)
+        double percentile(double percent) const
+        {
+            if (samples.empty())
+                return 0;
+            std::vector<double> sorted = samples;
+            double position = std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0 * sorted.size());
+            size_t rank = std::min((size_t)std::max(position, 1.0), sorted.size()) - 1;
+            std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+            return sorted[rank];
+        }
+
+        double max() const
+        {
+            return samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end());
+        }
+
+        // Returns the statistics as a json object (all the values are in milliseconds)
+        nlohmann::json toJson() const
+        {
+            return {
+                {"avg", average()},
+                {"p50", percentile(50)},
+                {"p95", percentile(95)},
+                {"p99", percentile(99)},
+                {"max", max()}};
+        }
+
+        void printSummary(std::ostream &stream, const std::string &label = "Frame times") const
+        {
+            stream << label << " over " << samples.size() << " frames (ms):" << std::fixed << std::setprecision(3)
+                   << " avg " << average()
+                   << " p50 " << percentile(50)
+                   << " p95 " << percentile(95)
+                   << " p99 " << percentile(99)
+                   << " max " << max() << std::endl;
+        }
+    };
+
+}
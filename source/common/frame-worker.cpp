@@ -0,0 +1,93 @@
+#include "frame-worker.hpp"
+
+#include <chrono>
+
+namespace our
+{
+
+    // Yields for the first few tries then sleeps so a waiting thread doesn't take a core from the driver
+    static void backoff(int &tries)
+    {
+        if (tries++ < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    void FrameWorker::launch()
+    {
+        if (running.exchange(true))
+            return;
+        thread = std::thread(&FrameWorker::loop, this);
+    }
+
+    void FrameWorker::stop()
+    {
+        if (!running.load())
+            return;
+        wait();
+        running.store(false);
+        unpark();
+        thread.join();
+    }
+
+    void FrameWorker::start(std::function<void()> job)
+    {
+        this->job = std::move(job);
+        // The release makes the job visible to the worker once it sees the new counter.
+        // The increment & the check of "parked" are sequentially consistent so either the worker sees the new job before parking
+        // or this thread sees that it parked (and wakes it).
+        started.fetch_add(1);
+        unpark();
+    }
+
+    void FrameWorker::park(uint64_t done)
+    {
+        std::unique_lock<std::mutex> lock(parkMutex);
+        parked.store(true);
+        wake.wait(lock, [&]()
+                  { return started.load() != done || !running.load(); });
+        parked.store(false);
+    }
+
+    void FrameWorker::unpark()
+    {
+        if (!parked.load())
+            return;
+        // Taking the mutex makes sure the worker is either before its last check or waiting (so the notification isn't lost)
+        std::lock_guard<std::mutex> lock(parkMutex);
+        wake.notify_one();
+    }
+
+    void FrameWorker::wait()
+    {
+        int tries = 0;
+        while (finished.load(std::memory_order_acquire) != started.load(std::memory_order_relaxed))
+            backoff(tries);
+    }
+
+    void FrameWorker::loop()
+    {
+        uint64_t done = finished.load();
+        int tries = 0;
+        while (true)
+        {
+            if (started.load(std::memory_order_acquire) == done)
+            {
+                if (!running.load())
+                    return;
+                // Spinning keeps the hand-off fast when the next job comes soon, then the worker parks so it costs nothing while idle
+                if (tries++ < 64)
+                    std::this_thread::yield();
+                else
+                    park(done);
+                continue;
+            }
+            tries = 0;
+            job();
+            // The release makes the results of the job visible to the main thread once it sees the new counter
+            finished.store(++done, std::memory_order_release);
+        }
+    }
+
+}
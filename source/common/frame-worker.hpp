@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace our
+{
+
+    // A worker thread that runs one job per frame next to the main thread (e.g. preparing the render packet of the next frame).
+    // "start" hands it a job and "wait" returns once the last job is done. The hand-off only uses atomic counters
+    // (the main thread spins for a moment then sleeps in short steps). An idle worker spins for a moment too then parks
+    // on a condition variable, whose mutex is only taken to park & to wake it (so "start" never locks while the worker is busy).
+    class FrameWorker
+    {
+        std::thread thread;
+        std::function<void()> job;
+        std::atomic<uint64_t> started{0}, finished{0};
+        std::atomic<bool> running{false};
+        // True while the worker is parked (or about to park) on "wake"
+        std::atomic<bool> parked{false};
+        std::mutex parkMutex;
+        std::condition_variable wake;
+
+        void loop();
+        // Blocks the worker until a job after "done" is started or the worker is stopped
+        void park(uint64_t done);
+        void unpark();
+
+    public:
+        // Starts & stops the thread (stopping waits for the last job first)
+        void launch();
+        void stop();
+        bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+        // Runs the job on the worker (the previous job must be done, see "wait")
+        void start(std::function<void()> job);
+        // Waits for the last started job to finish
+        void wait();
+
+        ~FrameWorker() { stop(); }
+    };
+
+}
@@ -0,0 +1,55 @@
+#include "gl-state.hpp"
+
+namespace our
+{
+
+    void GLState::invalidate()
+    {
+        cullFaceEnabled.known = depthTestEnabled.known = blendEnabled.known = false;
+        culledFace.known = frontFaceMode.known = depthFunction.known = blendEquationMode.known = false;
+        blendFactors.known = false;
+        blendConstant.known = false;
+        colorWriteMask.known = false;
+        depthWriteMask.known = false;
+        currentProgram.known = currentVertexArray.known = drawFramebuffer.known = readFramebuffer.known = false;
+        activeUnit.known = false;
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            textures[unit].known = samplers[unit].known = false;
+    }
+
+    void GLState::onProgramDeleted(GLuint program)
+    {
+        // A deleted program stays in use until another one is used, so we just forget what is in use
+        if (currentProgram.value == program)
+            currentProgram.known = false;
+    }
+
+    void GLState::onVertexArrayDeleted(GLuint vertexArray)
+    {
+        if (currentVertexArray.value == vertexArray)
+            currentVertexArray.value = 0;
+    }
+
+    void GLState::onFramebufferDeleted(GLuint framebuffer)
+    {
+        if (drawFramebuffer.value == framebuffer)
+            drawFramebuffer.value = 0;
+        if (readFramebuffer.value == framebuffer)
+            readFramebuffer.value = 0;
+    }
+
+    void GLState::onTextureDeleted(GLuint texture)
+    {
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            if (textures[unit].value == texture)
+                textures[unit].value = 0;
+    }
+
+    void GLState::onSamplerDeleted(GLuint sampler)
+    {
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            if (samplers[unit].value == sampler)
+                samplers[unit].value = 0;
+    }
+
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <utility>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "render-stats.hpp"
+
+namespace our
+{
+
+    // A value mirrored by GLState. After "invalidate", the value is unknown so the next call is always issued.
+    template <typename T>
+    struct CachedGLState
+    {
+        T value{};
+        bool known = false;
+
+        // Returns true if the value changed (and the GL call should be issued)
+        bool update(const T &newValue)
+        {
+            if (known && value == newValue)
+            {
+                RenderStats::current().skippedCalls++;
+                return false;
+            }
+            value = newValue;
+            known = true;
+            return true;
+        }
+    };
+
+    // This class mirrors the OpenGL state changed by our wrappers (PipelineState, ShaderProgram, Mesh, Texture2D, Sampler & the renderer)
+    // so that a call that would set a state to the value it already has is skipped.
+    // Every skipped call is counted in RenderStats::skippedCalls.
+    // Any code that changes these states without going through this class must call "invalidate" afterwards
+    // (e.g. the application does it after ImGui draws) so that the next call of each state is issued again.
+    class GLState
+    {
+        static constexpr int MAX_TEXTURE_UNITS = 32;
+
+        static inline CachedGLState<bool> cullFaceEnabled, depthTestEnabled, blendEnabled;
+        static inline CachedGLState<GLenum> culledFace, frontFaceMode, depthFunction, blendEquationMode;
+        static inline CachedGLState<std::array<GLenum, 4>> blendFactors; // The color source & destination then the alpha source & destination
+        static inline CachedGLState<glm::vec4> blendConstant;
+        static inline CachedGLState<glm::bvec4> colorWriteMask;
+        static inline CachedGLState<bool> depthWriteMask;
+        static inline CachedGLState<GLuint> currentProgram, currentVertexArray, drawFramebuffer, readFramebuffer;
+        static inline CachedGLState<GLenum> activeUnit;
+        static inline CachedGLState<GLuint> textures[MAX_TEXTURE_UNITS], samplers[MAX_TEXTURE_UNITS];
+
+        static CachedGLState<bool> *capability(GLenum capability)
+        {
+            switch (capability)
+            {
+            case GL_CULL_FACE:
+                return &cullFaceEnabled;
+            case GL_DEPTH_TEST:
+                return &depthTestEnabled;
+            case GL_BLEND:
+                return &blendEnabled;
+            default:
+                return nullptr;
+            }
+        }
+
+    public:
+        // Enables or disables a capability (only GL_CULL_FACE, GL_DEPTH_TEST & GL_BLEND are mirrored, the others are always issued)
+        static void setEnabled(GLenum cap, bool enabled)
+        {
+            CachedGLState<bool> *cached = capability(cap);
+            if (cached && !cached->update(enabled))
+                return;
+            if (enabled)
+                glEnable(cap);
+            else
+                glDisable(cap);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void cullFace(GLenum face)
+        {
+            if (!culledFace.update(face))
+                return;
+            glCullFace(face);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void frontFace(GLenum mode)
+        {
+            if (!frontFaceMode.update(mode))
+                return;
+            glFrontFace(mode);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void depthFunc(GLenum function)
+        {
+            if (!depthFunction.update(function))
+                return;
+            glDepthFunc(function);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void blendEquation(GLenum equation)
+        {
+            if (!blendEquationMode.update(equation))
+                return;
+            glBlendEquation(equation);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void blendFunc(GLenum source, GLenum destination)
+        {
+            if (!blendFactors.update({source, destination, source, destination}))
+                return;
+            glBlendFunc(source, destination);
+            RenderStats::current().stateChanges++;
+        }
+
+        // Sets different blending factors for the color & the alpha channels
+        static void blendFuncSeparate(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha)
+        {
+            if (!blendFactors.update({sourceColor, destinationColor, sourceAlpha, destinationAlpha}))
+                return;
+            glBlendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void blendColor(const glm::vec4 &color)
+        {
+            if (!blendConstant.update(color))
+                return;
+            glBlendColor(color.r, color.g, color.b, color.a);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void colorMask(const glm::bvec4 &mask)
+        {
+            if (!colorWriteMask.update(mask))
+                return;
+            glColorMask(mask.r, mask.g, mask.b, mask.a);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void depthMask(bool mask)
+        {
+            if (!depthWriteMask.update(mask))
+                return;
+            glDepthMask(mask);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void useProgram(GLuint program)
+        {
+            if (!currentProgram.update(program))
+                return;
+            glUseProgram(program);
+            RenderStats::current().programSwitches++;
+        }
+
+        static void bindVertexArray(GLuint vertexArray)
+        {
+            if (!currentVertexArray.update(vertexArray))
+                return;
+            glBindVertexArray(vertexArray);
+            RenderStats::current().stateChanges++;
+        }
+
+        // Binds a framebuffer to GL_DRAW_FRAMEBUFFER, GL_READ_FRAMEBUFFER or both (GL_FRAMEBUFFER)
+        static void bindFramebuffer(GLenum target, GLuint framebuffer)
+        {
+            bool draw = target != GL_READ_FRAMEBUFFER, read = target != GL_DRAW_FRAMEBUFFER;
+            bool drawChanged = draw && drawFramebuffer.update(framebuffer);
+            bool readChanged = read && readFramebuffer.update(framebuffer);
+            if (!drawChanged && !readChanged)
+                return;
+            // If only one of the two bindings changed, we only bind that one
+            glBindFramebuffer(drawChanged && readChanged ? target : (drawChanged ? GL_DRAW_FRAMEBUFFER : GL_READ_FRAMEBUFFER), framebuffer);
+            RenderStats::current().stateChanges++;
+        }
+
+        static void activeTexture(GLenum unit)
+        {
+            if (!activeUnit.update(unit))
+                return;
+            glActiveTexture(unit);
+            RenderStats::current().stateChanges++;
+        }
+
+        // Binds a texture to GL_TEXTURE_2D of the active texture unit
+        static void bindTexture2D(GLuint texture)
+        {
+            int unit = activeUnit.known ? (int)(activeUnit.value - GL_TEXTURE0) : -1;
+            if (unit >= 0 && unit < MAX_TEXTURE_UNITS && !textures[unit].update(texture))
+                return;
+            glBindTexture(GL_TEXTURE_2D, texture);
+            RenderStats::current().textureBinds++;
+        }
+
+        static void bindSampler(GLuint unit, GLuint sampler)
+        {
+            if (unit < MAX_TEXTURE_UNITS && !samplers[unit].update(sampler))
+                return;
+            glBindSampler(unit, sampler);
+            RenderStats::current().samplerBinds++;
+        }
+
+        // Marks every mirrored state as unknown so the next call of each state is issued
+        static void invalidate();
+
+        // These should be called when an object is deleted since OpenGL resets the bindings of deleted objects to 0
+        // and the object name could be reused by a new object
+        static void onProgramDeleted(GLuint program);
+        static void onVertexArrayDeleted(GLuint vertexArray);
+        static void onFramebufferDeleted(GLuint framebuffer);
+        static void onTextureDeleted(GLuint texture);
+        static void onSamplerDeleted(GLuint sampler);
+    };
+
+}
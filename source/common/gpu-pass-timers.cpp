@@ -0,0 +1,119 @@
+#include "gpu-pass-timers.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+#include <imgui.h>
+
+namespace our
+{
+
+    GLuint GPUPassTimers::acquire()
+    {
+        GLuint query;
+        if (available.empty())
+        {
+            glGenQueries(1, &query);
+        }
+        else
+        {
+            query = available.back();
+            available.pop_back();
+        }
+        return query;
+    }
+
+    void GPUPassTimers::begin(const std::string &name)
+    {
+        if (!enabled)
+            return;
+        Pass pass = {name, acquire(), acquire()};
+        glQueryCounter(pass.start, GL_TIMESTAMP);
+        current.push_back(pass);
+    }
+
+    void GPUPassTimers::end()
+    {
+        if (!enabled || current.empty())
+            return;
+        glQueryCounter(current.back().end, GL_TIMESTAMP);
+    }
+
+    void GPUPassTimers::endFrame(bool wait)
+    {
+        if (!current.empty())
+        {
+            pending.push_back(std::move(current));
+            current.clear();
+        }
+        while (!pending.empty())
+        {
+            std::vector<Pass> &frame = pending.front();
+            if (!wait)
+            {
+                // The queries finish in order so the frame is done once its last query is available
+                GLint ready = GL_FALSE;
+                glGetQueryObjectiv(frame.back().end, GL_QUERY_RESULT_AVAILABLE, &ready);
+                if (!ready)
+                    break;
+            }
+            last.clear();
+            for (Pass &pass : frame)
+            {
+                GLuint64 start = 0, end = 0;
+                glGetQueryObjectui64v(pass.start, GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(pass.end, GL_QUERY_RESULT, &end);
+                double milliseconds = (end - start) / 1e6;
+                last.push_back({pass.name, milliseconds});
+                auto it = std::find_if(timings.begin(), timings.end(), [&](const auto &entry)
+                                       { return entry.first == pass.name; });
+                if (it == timings.end())
+                    it = timings.insert(timings.end(), {pass.name, FrameTimings()});
+                it->second.record(milliseconds);
+                available.push_back(pass.start);
+                available.push_back(pass.end);
+            }
+            pending.pop_front();
+        }
+    }
+
+    void GPUPassTimers::destroy()
+    {
+        endFrame(true);
+        if (!available.empty())
+            glDeleteQueries((GLsizei)available.size(), available.data());
+        available.clear();
+    }
+
+    void GPUPassTimers::reset()
+    {
+        timings.clear();
+        last.clear();
+    }
+
+    nlohmann::json GPUPassTimers::toJson()
+    {
+        nlohmann::json result = nlohmann::json::object();
+        for (auto &[name, passTimings] : timings)
+            result[name] = passTimings.toJson();
+        return result;
+    }
+
+    void GPUPassTimers::printSummary(std::ostream &stream)
+    {
+        for (auto &[name, passTimings] : timings)
+            passTimings.printSummary(stream, "GPU " + name);
+    }
+
+    void GPUPassTimers::drawImGui()
+    {
+        if (last.empty())
+            return;
+        ImGui::Begin("Render Stats");
+        ImGui::Separator();
+        for (auto &[name, milliseconds] : last)
+            ImGui::Text("%-17s: %.3f ms", name.c_str(), milliseconds);
+        ImGui::End();
+    }
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <deque>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/gl.h>
+#include <json/json.hpp>
+
+#include "frame-timings.hpp"
+
+namespace our
+{
+
+    // Measures the GPU time of the named passes of each frame (e.g. "depth prepass", "opaque", "transparent") using timestamp queries,
+    // which unlike the GL_TIME_ELAPSED query of GPUTimer can be issued while the whole frame is being timed.
+    // The results are read a few frames later (when they are available) so the CPU never waits for the GPU.
+    // The times of all the timers are recorded per pass name in a shared table (like RenderStats) shown by the application.
+    class GPUPassTimers
+    {
+        struct Pass
+        {
+            std::string name;
+            GLuint start, end;
+        };
+        bool enabled = false;
+        std::vector<GLuint> available;
+        std::vector<Pass> current;           // The passes of the frame being recorded
+        std::deque<std::vector<Pass>> pending; // The frames whose queries are in flight
+
+        // The recorded times of each pass (in the order the passes were first seen) and the times of the last collected frame
+        static inline std::vector<std::pair<std::string, FrameTimings>> timings;
+        static inline std::vector<std::pair<std::string, double>> last;
+
+        GLuint acquire();
+
+    public:
+        void setEnabled(bool enabled) { this->enabled = enabled; }
+        bool isEnabled() const { return enabled; }
+
+        // Starts & ends a pass (the passes can't be nested). They do nothing if the timers are disabled.
+        void begin(const std::string &name);
+        void end();
+        // Queues the passes of the frame and records the times of the finished frames. If "wait" is true, it waits for all of them.
+        void endFrame(bool wait = false);
+        void destroy();
+
+        // Clears the recorded times (e.g. after the warm-up frames of a benchmark)
+        static void reset();
+        // Returns the average time of each pass as a json object (in milliseconds)
+        static nlohmann::json toJson();
+        static void printSummary(std::ostream &stream);
+        // Draws the times of the last frame in the render statistics window (if any pass was timed)
+        static void drawImGui();
+    };
+
+}
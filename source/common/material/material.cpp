@@ -6,12 +6,25 @@
 namespace our
 {
 
+    // The uniforms set by the materials (hashed at compile time)
+    namespace uniforms
+    {
+        static constexpr UniformID tint("tint");
+        static constexpr UniformID alphaThreshold("alphaThreshold");
+        static constexpr UniformID tex("tex");
+        static constexpr UniformID albedo("material.albedo");
+        static constexpr UniformID specular("material.specular");
+        static constexpr UniformID emissive("material.emissive");
+        static constexpr UniformID roughness("material.roughness");
+        static constexpr UniformID ambientOcclusion("material.ambient_occlusion");
+    }
+
     // This function should setup the pipeline state and set the shader to be used
-    void Material::setup() const
+    void Material::setup(uint32_t variant) const
     {
         // DONE: (Req 7) Write this function
         this->pipelineState.setup();
-        this->shader->use();
+        this->shader->getVariant(variant)->use();
     }
 
     // This function read the material data from a json object
@@ -30,11 +43,11 @@ namespace our
 
     // This function should call the setup of its parent and
     // set the "tint" uniform to the value in the member variable tint
-    void TintedMaterial::setup() const
+    void TintedMaterial::setup(uint32_t variant) const
     {
         // DONE: (Req 7) Write this function
-        Material::setup();
-        shader->set("tint", this->tint);
+        Material::setup(variant);
+        shader->getVariant(variant)->set(uniforms::tint, this->tint);
     }
 
     // This function read the material data from a json object
@@ -49,12 +62,13 @@ namespace our
     // This function should call the setup of its parent and
     // set the "alphaThreshold" uniform to the value in the member variable alphaThreshold
     // Then it should bind the texture and sampler to a texture unit and send the unit number to the uniform variable "tex"
-    void TexturedMaterial::setup() const
+    void TexturedMaterial::setup(uint32_t variant) const
     {
         // DONE: (Req 7) Write this function
-        TintedMaterial::setup();
-        this->shader->set("alphaThreshold", this->alphaThreshold);
-        glActiveTexture(GL_TEXTURE0); // we send it unit 0
+        TintedMaterial::setup(variant);
+        ShaderProgram *shader = this->shader->getVariant(variant);
+        shader->set(uniforms::alphaThreshold, this->alphaThreshold);
+        GLState::activeTexture(GL_TEXTURE0); // we send it unit 0
         // check if the texture is null call the unbind
         if (this->texture)
             this->texture->bind();
@@ -65,7 +79,7 @@ namespace our
             this->sampler->bind(0);
         else
             this->sampler->unbind(0);
-        shader->set("tex", 0);
+        shader->set(uniforms::tex, 0);
     }
 
     // This function read the material data from a json object
@@ -79,61 +93,62 @@ namespace our
         sampler = AssetLoader<Sampler>::get(data.value("sampler", ""));
     }
 
-    void LightMaterial::setup() const
+    void LightMaterial::setup(uint32_t variant) const
     {
-        Material::setup();
+        Material::setup(variant);
+        ShaderProgram *shader = this->shader->getVariant(variant);
         if (this->albedo) {
             // activate the texture unit 0
-            glActiveTexture(GL_TEXTURE0);
+            GLState::activeTexture(GL_TEXTURE0);
             // bind the texture
             this->albedo->bind();
             // bind the sampler
             this->sampler->bind(0);
             // send the texture unit to the uniform variable "material.albedo" 
-            shader->set("material.albedo", 0);
+            shader->set(uniforms::albedo, 0);
         }
 
         if (this->specular) {
             // activate the texture unit 1
-            glActiveTexture(GL_TEXTURE1);
+            GLState::activeTexture(GL_TEXTURE1);
             // bind the texture
             this->specular->bind();
             // bind the sampler
             this->sampler->bind(1);
             // send the texture unit to the uniform variable "material.specular"
-            shader->set("material.specular", 1);
+            shader->set(uniforms::specular, 1);
         }
         if (this->emissive) {
             // activate the texture unit 2
-            glActiveTexture(GL_TEXTURE2);
+            GLState::activeTexture(GL_TEXTURE2);
             // bind the texture
             this->emissive->bind();
             // bind the sampler
             this->sampler->bind(2);
             // send the texture unit to the uniform variable "material.emissive"
-            shader->set("material.emissive", 2);
+            shader->set(uniforms::emissive, 2);
         }
         if (this->roughness)
         {
             // activate the texture unit 3
-            glActiveTexture(GL_TEXTURE3);
+            GLState::activeTexture(GL_TEXTURE3);
             // bind the texture
             this->roughness->bind();
             // bind the sampler
             this->sampler->bind(3);
             // send the texture unit to the uniform variable "material.roughness"
-            shader->set("material.roughness", 3);
+            shader->set(uniforms::roughness, 3);
         }
         if (this->ambient_occlusion)
         {
             // activate the texture unit 4
-            glActiveTexture(GL_TEXTURE4);
+            GLState::activeTexture(GL_TEXTURE4);
             // bind the texture
             this->ambient_occlusion->bind();
             // bind the sampler
             this->sampler->bind(4);
             // send the texture unit to the uniform variable "material.ambient_occlusion"
-            shader->set("material.ambient_occlusion", 4);
+            shader->set(uniforms::ambientOcclusion, 4);
         }
         
         
@@ -21,11 +21,19 @@ namespace our {
         PipelineState pipelineState;
         ShaderProgram* shader;
         bool transparent;
+
+        // Returns a small sequential ID used by the renderer sort keys to group the draws of the same material
+        uint32_t getSortID() const { return sortID; }
         
         // This function does 2 things: setup the pipeline state and set the shader program to be used
-        virtual void setup() const;
+        // "variant" selects a variant of the shader (see "shader_variant"), the caller must check that the shader supports it
+        virtual void setup(uint32_t variant = shader_variant::NONE) const;
         // This function read a material from a json object
         virtual void deserialize(const nlohmann::json& data);
+
+    private:
+        uint32_t sortID = nextSortID++;
+        static inline uint32_t nextSortID = 0;
     };
 
     // This material adds a uniform for a tint (a color that will be sent to the shader)
@@ -34,7 +42,7 @@ namespace our {
     public:
         glm::vec4 tint;
 
-        void setup() const override;
+        void setup(uint32_t variant = shader_variant::NONE) const override;
         void deserialize(const nlohmann::json& data) override;
     };
 
@@ -49,7 +57,7 @@ namespace our {
         Sampler* sampler;
         float alphaThreshold;
 
-        void setup() const override;
+        void setup(uint32_t variant = shader_variant::NONE) const override;
         void deserialize(const nlohmann::json& data) override;
     };
 
@@ -62,7 +70,7 @@ namespace our {
         Texture2D* ambient_occlusion;
         Sampler* sampler;
 
-        void setup() const override;
+        void setup(uint32_t variant = shader_variant::NONE) const override;
         void deserialize(const nlohmann::json& data) override;
     };
     // This function returns a new material instance based on the given type
@@ -4,6 +4,8 @@
 #include <glm/vec4.hpp>
 #include <json/json.hpp>
 
+#include "../gl-state.hpp"
+
 namespace our {
     // There are some options in the render pipeline that we cannot control via shaders
     // such as blending, depth testing and so on
@@ -42,50 +44,35 @@ namespace our {
         // For example, if faceCulling.enabled is true, you should call glEnable(GL_CULL_FACE), otherwise, you should call glDisable(GL_CULL_FACE)
         void setup() const {
             //DONE: (Req 4) Write this function
+            // The calls go through GLState which skips the ones that would not change anything
+            // (and counts the issued ones as state changes for the render statistics)
+            GLState::setEnabled(GL_CULL_FACE, faceCulling.enabled);
             if (faceCulling.enabled)
             {
-                // enable back face culling for the current pipeline
-                glEnable(GL_CULL_FACE);
                 // set the culled face to be the back face (GL_BACK) 
                 //culled means that the face not rendered
-                glCullFace(faceCulling.culledFace);
+                GLState::cullFace(faceCulling.culledFace);
                 // set the front face to be the counter-clockwise face (GL_CCW)
                 // front face is the face that is rendered
-                glFrontFace(faceCulling.frontFace);
-            }
-            else
-            {
-                glDisable(GL_CULL_FACE);
+                GLState::frontFace(faceCulling.frontFace);
             }
+            // enable depth testing for the current pipeline
+            // to render the scene in the correct order
+            GLState::setEnabled(GL_DEPTH_TEST, depthTesting.enabled);
             if (depthTesting.enabled)
-            {
-                // enable depth testing for the current pipeline
-                // to render the scene in the correct order
-                glEnable(GL_DEPTH_TEST);
-                glDepthFunc(depthTesting.function);
-            }
-            else
-            {
-                glDisable(GL_DEPTH_TEST);
-            }
+                GLState::depthFunc(depthTesting.function);
+            GLState::setEnabled(GL_BLEND, blending.enabled);
             if (blending.enabled)
             {
-                // enable blending for the current pipeline
-                glEnable(GL_BLEND);
                 // set the blending color
-                glBlendColor(blending.constantColor.r, blending.constantColor.g, blending.constantColor.b, blending.constantColor.a);
+                GLState::blendColor(blending.constantColor);
                 // set the blending equation
-                glBlendEquation(blending.equation);
+                GLState::blendEquation(blending.equation);
                 // set the blending factors
-                glBlendFunc(blending.sourceFactor, blending.destinationFactor);
-            }
-            else
-            {
-                // disable blending for the current pipeline
-                glDisable(GL_BLEND);
+                GLState::blendFunc(blending.sourceFactor, blending.destinationFactor);
             }
-            glColorMask(colorMask.r, colorMask.g, colorMask.b, colorMask.a);
-            glDepthMask(depthMask);
+            GLState::colorMask(colorMask);
+            GLState::depthMask(depthMask);
         }
 
         // Given a json object, this function deserializes a PipelineState structure
@@ -0,0 +1,102 @@
+#include "geometry-arena.hpp"
+#include "../render-stats.hpp"
+#include "../gl-state.hpp"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace our
+{
+
+    // The arenas by vertex format & index type
+    static std::map<std::pair<VertexFormat, GLenum>, GeometryArena *> arenas;
+
+    // The initial size of the buffers of an arena (in bytes). They grow by doubling when they are full.
+    static constexpr GLsizeiptr INITIAL_CAPACITY = 1 << 20;
+
+    GeometryArena::GeometryArena(VertexFormat format, GLenum indexType) : format(format), indexType(indexType)
+    {
+        indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        glGenVertexArrays(1, &VAO);
+    }
+
+    GeometryArena::~GeometryArena()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        GLState::onVertexArrayDeleted(VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+    void GeometryArena::reserve(GLuint &buffer, GLenum target, GLsizeiptr usedBytes, GLsizeiptr &capacity, GLsizeiptr neededBytes)
+    {
+        if (neededBytes <= capacity)
+            return;
+        GLsizeiptr newCapacity = std::max(INITIAL_CAPACITY, capacity);
+        while (newCapacity < neededBytes)
+            newCapacity *= 2;
+        GLuint newBuffer;
+        glGenBuffers(1, &newBuffer);
+        glBindBuffer(target, newBuffer);
+        glBufferData(target, newCapacity, nullptr, GL_STATIC_DRAW);
+        // The data of the old buffer is copied on the GPU then the old buffer is deleted
+        if (buffer != 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0, usedBytes);
+            glDeleteBuffers(1, &buffer);
+        }
+        buffer = newBuffer;
+        capacity = newCapacity;
+    }
+
+    GeometryArena::Allocation GeometryArena::allocate(const void *vertexData, GLsizei vertexCount, const void *indexData, GLsizei indexCount)
+    {
+        // The element buffer binding is a part of the vertex array state so the vertex array must be bound first
+        GLState::bindVertexArray(VAO);
+
+        GLsizeiptr stride = getVertexLayout(format).stride;
+        GLsizeiptr newVertexBytes = vertexCount * stride, newIndexBytes = indexCount * indexSize;
+        GLuint oldVBO = VBO;
+        reserve(VBO, GL_ARRAY_BUFFER, vertexBytes, vertexCapacity, vertexBytes + newVertexBytes);
+        // The attributes are pointed again if the vertex buffer moved
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        if (VBO != oldVBO)
+            getVertexLayout(format).apply();
+        reserve(EBO, GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexCapacity, indexBytes + newIndexBytes);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+        Allocation allocation = {(GLint)(vertexBytes / stride), (GLsizei)(indexBytes / indexSize)};
+        glBufferSubData(GL_ARRAY_BUFFER, vertexBytes, newVertexBytes, vertexData);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, newIndexBytes, indexData);
+        vertexBytes += newVertexBytes;
+        indexBytes += newIndexBytes;
+        meshCount++;
+        RenderStats::current().bytesUploaded += newVertexBytes + newIndexBytes;
+        return allocation;
+    }
+
+    void GeometryArena::release()
+    {
+        // Once the arena is empty, the next allocations start from the beginning of the buffers again
+        if (--meshCount == 0)
+            vertexBytes = indexBytes = 0;
+    }
+
+    GeometryArena *GeometryArena::get(VertexFormat format, GLenum indexType)
+    {
+        GeometryArena *&arena = arenas[{format, indexType}];
+        if (!arena)
+            arena = new GeometryArena(format, indexType);
+        return arena;
+    }
+
+    void GeometryArena::clear()
+    {
+        for (auto &[key, arena] : arenas)
+            delete arena;
+        arenas.clear();
+    }
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include "vertex-layout.hpp"
+#include "instance-buffer.hpp"
+
+namespace our
+{
+
+    // A geometry arena holds the vertices & elements of many meshes in a single vertex buffer and a single element buffer
+    // (one arena per vertex format & index type) read by a single vertex array. Each mesh is a sub-allocation
+    // (a base vertex & a first index) drawn with glDrawElementsBaseVertex, so consecutive draws of different meshes don't switch the vertex array.
+    // The arena only grows (the ranges of the released meshes are not reused) and it is emptied when its last mesh is released.
+    class GeometryArena
+    {
+        VertexFormat format;
+        GLenum indexType;
+        GLsizei indexSize;
+        GLuint VAO = 0, VBO = 0, EBO = 0;
+        // The used & allocated sizes of the buffers (in bytes)
+        GLsizeiptr vertexBytes = 0, vertexCapacity = 0;
+        GLsizeiptr indexBytes = 0, indexCapacity = 0;
+        // The number of meshes allocated in this arena (and not released yet)
+        int meshCount = 0;
+        InstanceBinding instanceBinding;
+
+        GeometryArena(VertexFormat format, GLenum indexType);
+        ~GeometryArena();
+
+        // Makes sure the buffer bound to "target" can hold "neededBytes" by moving it to a bigger buffer (copying the "usedBytes" it holds)
+        void reserve(GLuint &buffer, GLenum target, GLsizeiptr usedBytes, GLsizeiptr &capacity, GLsizeiptr neededBytes);
+
+    public:
+        // A mesh in the arena: its vertices start at "baseVertex" & its elements start at "firstIndex"
+        struct Allocation
+        {
+            GLint baseVertex;
+            GLsizei firstIndex;
+        };
+
+        // Copies the vertices (already in the format of the arena) & the elements (of the index type of the arena) into the arena
+        Allocation allocate(const void *vertexData, GLsizei vertexCount, const void *indexData, GLsizei indexCount);
+        // Releases a mesh allocated in this arena
+        void release();
+
+        GLuint getVertexArray() const { return VAO; }
+        InstanceBinding &getInstanceBinding() { return instanceBinding; }
+
+        // Returns the arena of the given vertex format & index type (creating it if needed)
+        static GeometryArena *get(VertexFormat format, GLenum indexType);
+        // Deletes all the arenas. All the meshes allocated in them must be deleted first.
+        static void clear();
+
+        GeometryArena(const GeometryArena &) = delete;
+        GeometryArena &operator=(const GeometryArena &) = delete;
+    };
+
+}
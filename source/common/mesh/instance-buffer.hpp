@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+
+#include <glad/gl.h>
+#include <glm/mat4x4.hpp>
+
+#include "../render-stats.hpp"
+
+namespace our
+{
+
+// The attribute locations of the per-instance data (each matrix takes 4 locations, one per column)
+#define ATTRIB_LOC_INSTANCE_M 4
+#define ATTRIB_LOC_INSTANCE_M_IT 8
+
+    // The data of a single instance as read by the instanced shader variants ("instance_M" & "instance_M_IT")
+    struct InstanceData
+    {
+        glm::mat4 M;    // The model (local to world) matrix
+        glm::mat4 M_IT; // The inverse transpose of the model matrix (only filled for lit materials)
+    };
+
+    // This class wraps a vertex buffer holding the instance data of a whole frame.
+    // "begin" orphans the buffer once per frame, then every instanced batch appends its instances and draws them from the returned offset.
+    class InstanceBuffer
+    {
+        GLuint buffer;
+        GLsizeiptr capacity = 0, used = 0;
+        // OpenGL may reuse the name of a deleted buffer so the meshes recognize the buffers using this ID instead
+        uint32_t id = nextID++;
+        static inline uint32_t nextID = 1;
+
+    public:
+        InstanceBuffer()
+        {
+            glGenBuffers(1, &buffer);
+        }
+        ~InstanceBuffer()
+        {
+            glDeleteBuffers(1, &buffer);
+        }
+
+        GLuint getOpenGLName() const { return buffer; }
+        uint32_t getID() const { return id; }
+
+        // Orphans the buffer (growing it to at least "bytes") so the frame doesn't wait for the draws of the last frame
+        void begin(GLsizeiptr bytes)
+        {
+            if (bytes > capacity)
+                capacity = std::max(bytes, 2 * capacity);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+            used = 0;
+        }
+
+        // Copies the instances into the buffer and returns their offset in bytes
+        GLintptr append(const InstanceData *instances, GLsizei count)
+        {
+            GLsizeiptr bytes = count * (GLsizeiptr)sizeof(InstanceData);
+            GLintptr offset = used;
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, instances);
+            used += bytes;
+            RenderStats::current().bytesUploaded += bytes;
+            return offset;
+        }
+
+        InstanceBuffer(const InstanceBuffer &) = delete;
+        InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+    };
+
+    // The instance buffer & offset from which the instance attributes of a vertex array currently read.
+    // A vertex array shared by many meshes (see GeometryArena) shares a single binding so its attributes are only re-pointed when needed.
+    struct InstanceBinding
+    {
+        uint32_t bufferID = 0;
+        GLintptr offset = -1;
+    };
+
+}
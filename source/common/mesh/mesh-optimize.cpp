@@ -0,0 +1,233 @@
+#include "mesh-optimize.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+namespace
+{
+
+    // The parameters of Forsyth's vertex scores ("Linear-Speed Vertex Cache Optimisation", 2006)
+    constexpr int FORSYTH_CACHE_SIZE = 32;
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    float vertexScore(int cachePosition, int remainingTriangles)
+    {
+        // A vertex without triangles left to draw is worthless
+        if (remainingTriangles == 0)
+            return -1.0f;
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // The vertices of the last triangle get a fixed score so the next triangle doesn't just reuse the same edge
+            if (cachePosition < 3)
+                score = LAST_TRIANGLE_SCORE;
+            else
+                score = std::pow(1.0f - (float)(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        // The vertices with few remaining triangles are boosted so they are finished (and leave the cache) early
+        score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+}
+
+float our::mesh_utils::computeACMR(const std::vector<GLuint> &elements, size_t vertexCount, int cacheSize)
+{
+    size_t triangleCount = elements.size() / 3;
+    if (triangleCount == 0)
+        return 0.0f;
+    // A FIFO cache where a vertex is in the cache if it was inserted less than "cacheSize" misses ago
+    std::vector<size_t> insertedAt(vertexCount, SIZE_MAX);
+    size_t misses = 0;
+    for (GLuint vertex : elements)
+    {
+        if (insertedAt[vertex] == SIZE_MAX || misses - insertedAt[vertex] >= (size_t)cacheSize)
+            insertedAt[vertex] = misses++;
+    }
+    return (float)misses / triangleCount;
+}
+
+void our::mesh_utils::optimizeVertexCache(std::vector<GLuint> &elements, size_t vertexCount)
+{
+    size_t triangleCount = elements.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // The triangles of each vertex (compressed rows) where the first "remaining" entries are the triangles not yet drawn
+    std::vector<uint32_t> offsets(vertexCount + 1, 0), remaining(vertexCount, 0);
+    for (GLuint vertex : elements)
+        remaining[vertex]++;
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+    std::vector<uint32_t> adjacency(elements.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t index = 0; index < elements.size(); index++)
+            adjacency[fill[elements[index]]++] = (uint32_t)(index / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> scores(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        scores[vertex] = vertexScore(-1, remaining[vertex]);
+    std::vector<float> triangleScores(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+        triangleScores[triangle] = scores[elements[3 * triangle]] + scores[elements[3 * triangle + 1]] + scores[elements[3 * triangle + 2]];
+    std::vector<uint8_t> emitted(triangleCount, 0);
+
+    std::vector<GLuint> result;
+    result.reserve(elements.size());
+    // The cache has 3 extra entries since the 3 vertices of a new triangle are pushed before the oldest entries are dropped
+    std::vector<GLuint> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t scanStart = 0;
+    int64_t best = -1;
+    for (size_t step = 0; step < triangleCount; step++)
+    {
+        // If no triangle around the cache is left, we restart from the first triangle not drawn yet
+        // (searching for the best score over all the triangles would make the meshes with many separate parts quadratic)
+        if (best < 0)
+        {
+            while (emitted[scanStart])
+                scanStart++;
+            best = (int64_t)scanStart;
+        }
+
+        // Emit the triangle and remove it from the triangle lists of its vertices
+        emitted[best] = 1;
+        GLuint corners[3] = {elements[3 * best], elements[3 * best + 1], elements[3 * best + 2]};
+        result.insert(result.end(), corners, corners + 3);
+        for (GLuint vertex : corners)
+        {
+            uint32_t *begin = adjacency.data() + offsets[vertex], *end = begin + remaining[vertex];
+            std::swap(*std::find(begin, end, (uint32_t)best), *(end - 1));
+            remaining[vertex]--;
+        }
+
+        // Move the corners to the front of the cache (in LRU order) then update the scores of everything that was in the cache
+        nextCache.assign(corners, corners + 3);
+        for (GLuint vertex : cache)
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                nextCache.push_back(vertex);
+        cache.swap(nextCache);
+        for (size_t position = 0; position < cache.size(); position++)
+        {
+            GLuint vertex = cache[position];
+            cachePosition[vertex] = position < FORSYTH_CACHE_SIZE ? (int)position : -1;
+            float score = vertexScore(cachePosition[vertex], remaining[vertex]);
+            float delta = score - scores[vertex];
+            scores[vertex] = score;
+            for (uint32_t offset = offsets[vertex]; offset < offsets[vertex] + remaining[vertex]; offset++)
+                triangleScores[adjacency[offset]] += delta;
+        }
+        if (cache.size() > FORSYTH_CACHE_SIZE)
+            cache.resize(FORSYTH_CACHE_SIZE);
+
+        // The next triangle is the best one around the cache
+        best = -1;
+        float bestScore = -INFINITY;
+        for (GLuint vertex : cache)
+            for (uint32_t offset = offsets[vertex]; offset < offsets[vertex] + remaining[vertex]; offset++)
+            {
+                uint32_t triangle = adjacency[offset];
+                if (triangleScores[triangle] > bestScore)
+                {
+                    bestScore = triangleScores[triangle];
+                    best = triangle;
+                }
+            }
+    }
+    elements.swap(result);
+}
+
+void our::mesh_utils::optimizeOverdraw(std::vector<GLuint> &elements, const std::vector<Vertex> &vertices)
+{
+    size_t triangleCount = elements.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Split the triangles into clusters at the triangles whose 3 vertices all miss the cache (where the cache optimizer restarted)
+    // The tiny clusters are merged with the next ones since sorting them would hurt the cache more than it helps the overdraw
+    constexpr size_t MIN_CLUSTER_TRIANGLES = 16;
+    std::vector<size_t> clusterStarts;
+    std::vector<size_t> insertedAt(vertices.size(), SIZE_MAX);
+    size_t misses = 0;
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        int triangleMisses = 0;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            GLuint vertex = elements[3 * triangle + corner];
+            if (insertedAt[vertex] == SIZE_MAX || misses - insertedAt[vertex] >= (size_t)ACMR_CACHE_SIZE)
+            {
+                insertedAt[vertex] = misses++;
+                triangleMisses++;
+            }
+        }
+        if (triangle == 0 || (triangleMisses == 3 && triangle - clusterStarts.back() >= MIN_CLUSTER_TRIANGLES))
+            clusterStarts.push_back(triangle);
+    }
+    if (clusterStarts.size() < 2)
+        return;
+
+    // Sort the clusters by how much they face away from the center of the mesh (the outer surfaces are drawn first)
+    glm::vec3 meshCenter = glm::vec3(0.0f);
+    for (GLuint vertex : elements)
+        meshCenter += vertices[vertex].position;
+    meshCenter /= (float)elements.size();
+    std::vector<float> clusterSortKeys(clusterStarts.size());
+    for (size_t cluster = 0; cluster < clusterStarts.size(); cluster++)
+    {
+        size_t begin = clusterStarts[cluster], end = cluster + 1 < clusterStarts.size() ? clusterStarts[cluster + 1] : triangleCount;
+        glm::vec3 centroid = glm::vec3(0.0f), normal = glm::vec3(0.0f);
+        float area = 0.0f;
+        for (size_t triangle = begin; triangle < end; triangle++)
+        {
+            glm::vec3 p0 = vertices[elements[3 * triangle]].position, p1 = vertices[elements[3 * triangle + 1]].position, p2 = vertices[elements[3 * triangle + 2]].position;
+            glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+            float triangleArea = glm::length(areaNormal);
+            centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            normal += areaNormal;
+            area += triangleArea;
+        }
+        centroid = area > 0.0f ? centroid / area : vertices[elements[3 * begin]].position;
+        float normalLength = glm::length(normal);
+        clusterSortKeys[cluster] = normalLength > 0.0f ? glm::dot(centroid - meshCenter, normal / normalLength) : 0.0f;
+    }
+    std::vector<size_t> order(clusterStarts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t first, size_t second)
+                     { return clusterSortKeys[first] > clusterSortKeys[second]; });
+
+    std::vector<GLuint> result;
+    result.reserve(elements.size());
+    for (size_t cluster : order)
+    {
+        size_t begin = clusterStarts[cluster], end = cluster + 1 < clusterStarts.size() ? clusterStarts[cluster + 1] : triangleCount;
+        result.insert(result.end(), elements.begin() + 3 * begin, elements.begin() + 3 * end);
+    }
+    elements.swap(result);
+}
+
+void our::mesh_utils::optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &elements)
+{
+    std::vector<GLuint> remap(vertices.size(), UINT32_MAX);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (GLuint &vertex : elements)
+    {
+        if (remap[vertex] == UINT32_MAX)
+        {
+            remap[vertex] = (GLuint)result.size();
+            result.push_back(vertices[vertex]);
+        }
+        vertex = remap[vertex];
+    }
+    vertices.swap(result);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "vertex.hpp"
+
+namespace our::mesh_utils
+{
+
+    // The number of entries of the post-transform vertex cache assumed when measuring the ACMR (a typical FIFO size)
+    constexpr int ACMR_CACHE_SIZE = 16;
+
+    // Returns the average cache miss ratio (transformed vertices per triangle) of the triangle list with a FIFO cache of the given size.
+    // It is 3 in the worst case and approaches 0.5 for large regular meshes.
+    float computeACMR(const std::vector<GLuint> &elements, size_t vertexCount, int cacheSize = ACMR_CACHE_SIZE);
+
+    // Reorders the triangles for the post-transform vertex cache using Tom Forsyth's linear-speed algorithm (in place)
+    void optimizeVertexCache(std::vector<GLuint> &elements, size_t vertexCount);
+
+    // Reorders the clusters of a cache optimized triangle list so the triangles facing away from the mesh center are drawn first,
+    // which lets the early depth test reject more of the triangles behind them (in place).
+    // The clusters are the runs of triangles between the points where the vertex cache is restarted, so the cache efficiency is mostly kept.
+    void optimizeOverdraw(std::vector<GLuint> &elements, const std::vector<Vertex> &vertices);
+
+    // Reorders the vertices in the order of their first use by the elements (and drops the unused vertices) so the vertex fetches
+    // of neighbouring triangles read neighbouring memory. The elements are remapped in place.
+    void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &elements);
+
+}
@@ -0,0 +1,275 @@
+#include "mesh-simplify.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace
+{
+
+    // A symmetric 4x4 matrix storing the sum of the squared distances to a set of planes (only the upper triangle is stored)
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+
+        // Adds the plane dot(normal, p) + distance = 0 (the normal must be normalized)
+        void addPlane(const glm::dvec3 &normal, double distance, double weight)
+        {
+            a00 += weight * normal.x * normal.x;
+            a01 += weight * normal.x * normal.y;
+            a02 += weight * normal.x * normal.z;
+            a03 += weight * normal.x * distance;
+            a11 += weight * normal.y * normal.y;
+            a12 += weight * normal.y * normal.z;
+            a13 += weight * normal.y * distance;
+            a22 += weight * normal.z * normal.z;
+            a23 += weight * normal.z * distance;
+            a33 += weight * distance * distance;
+        }
+
+        Quadric &operator+=(const Quadric &other)
+        {
+            a00 += other.a00, a01 += other.a01, a02 += other.a02, a03 += other.a03;
+            a11 += other.a11, a12 += other.a12, a13 += other.a13;
+            a22 += other.a22, a23 += other.a23;
+            a33 += other.a33;
+            return *this;
+        }
+
+        // Returns the weighted sum of the squared distances from the point to the planes
+        double evaluate(const glm::dvec3 &p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                   a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                   a22 * z * z + 2 * a23 * z +
+                   a33;
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from, to;
+    };
+
+    uint64_t edgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+    }
+
+    // The borders get planes this many times heavier than the surface planes so they move as little as possible
+    constexpr double BORDER_WEIGHT = 10.0;
+    // The maximum number of collapse passes (each pass collapses a set of independent edges)
+    constexpr int MAX_PASSES = 64;
+
+}
+
+std::vector<GLuint> our::mesh_utils::simplify(const std::vector<Vertex> &vertices, const std::vector<GLuint> &elements, size_t targetTriangleCount)
+{
+    // Weld the vertices by position, each position keeps the list of its vertices (wedges) which differ in their other attributes
+    std::unordered_map<glm::vec3, uint32_t> positionIDs;
+    std::vector<uint32_t> positionOf(vertices.size());
+    std::vector<glm::dvec3> positions;
+    std::vector<std::vector<uint32_t>> wedges;
+    for (uint32_t vertex = 0; vertex < vertices.size(); vertex++)
+    {
+        auto [it, inserted] = positionIDs.try_emplace(vertices[vertex].position, (uint32_t)positions.size());
+        if (inserted)
+        {
+            positions.push_back(glm::dvec3(vertices[vertex].position));
+            wedges.emplace_back();
+        }
+        positionOf[vertex] = it->second;
+        wedges[it->second].push_back(vertex);
+    }
+    size_t positionCount = positions.size();
+
+    // Keep the triangles that are not degenerate
+    std::vector<GLuint> triangles;
+    triangles.reserve(elements.size());
+    for (size_t index = 0; index + 2 < elements.size(); index += 3)
+    {
+        uint32_t p0 = positionOf[elements[index]], p1 = positionOf[elements[index + 1]], p2 = positionOf[elements[index + 2]];
+        if (p0 != p1 && p1 != p2 && p2 != p0)
+            triangles.insert(triangles.end(), {elements[index], elements[index + 1], elements[index + 2]});
+    }
+
+    // Each position starts with the planes of its triangles (weighted by the triangle areas)
+    std::vector<Quadric> quadrics(positionCount);
+    std::unordered_map<uint64_t, int> edgeUses;
+    for (size_t index = 0; index < triangles.size(); index += 3)
+    {
+        uint32_t corners[3] = {positionOf[triangles[index]], positionOf[triangles[index + 1]], positionOf[triangles[index + 2]]};
+        glm::dvec3 normal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+        double length = glm::length(normal);
+        if (length == 0)
+            continue;
+        normal /= length;
+        double distance = -glm::dot(normal, positions[corners[0]]);
+        for (uint32_t corner : corners)
+            quadrics[corner].addPlane(normal, distance, length * 0.5);
+        for (int edge = 0; edge < 3; edge++)
+            edgeUses[edgeKey(corners[edge], corners[(edge + 1) % 3])]++;
+    }
+    // The border edges (used by a single triangle) get a plane that contains the edge and is perpendicular to the triangle
+    for (size_t index = 0; index < triangles.size(); index += 3)
+    {
+        uint32_t corners[3] = {positionOf[triangles[index]], positionOf[triangles[index + 1]], positionOf[triangles[index + 2]]};
+        glm::dvec3 normal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+        if (glm::length(normal) == 0)
+            continue;
+        for (int edge = 0; edge < 3; edge++)
+        {
+            uint32_t a = corners[edge], b = corners[(edge + 1) % 3];
+            if (edgeUses[edgeKey(a, b)] != 1)
+                continue;
+            glm::dvec3 direction = positions[b] - positions[a];
+            glm::dvec3 borderNormal = glm::cross(direction, normal);
+            double length = glm::length(borderNormal);
+            if (length == 0)
+                continue;
+            borderNormal /= length;
+            double distance = -glm::dot(borderNormal, positions[a]);
+            double weight = BORDER_WEIGHT * glm::dot(direction, direction);
+            quadrics[a].addPlane(borderNormal, distance, weight);
+            quadrics[b].addPlane(borderNormal, distance, weight);
+        }
+    }
+
+    std::vector<uint32_t> vertexRemap(vertices.size());
+    std::vector<uint32_t> adjacencyOffsets, adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint8_t> locked;
+    for (int pass = 0; pass < MAX_PASSES && triangles.size() / 3 > targetTriangleCount; pass++)
+    {
+        // Build the triangles around each position (compressed rows)
+        adjacencyOffsets.assign(positionCount + 1, 0);
+        for (GLuint vertex : triangles)
+            adjacencyOffsets[positionOf[vertex] + 1]++;
+        for (size_t position = 0; position < positionCount; position++)
+            adjacencyOffsets[position + 1] += adjacencyOffsets[position];
+        adjacency.resize(triangles.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t index = 0; index < triangles.size(); index++)
+                adjacency[fill[positionOf[triangles[index]]]++] = (uint32_t)(index / 3);
+        }
+
+        // Every edge collapses into the endpoint that gives the smaller error
+        collapses.clear();
+        std::unordered_map<uint64_t, bool> visited;
+        for (size_t index = 0; index < triangles.size(); index += 3)
+        {
+            for (int edge = 0; edge < 3; edge++)
+            {
+                uint32_t a = positionOf[triangles[index + edge]], b = positionOf[triangles[index + (edge + 1) % 3]];
+                if (!visited.emplace(edgeKey(a, b), true).second)
+                    continue;
+                Quadric sum = quadrics[a];
+                sum += quadrics[b];
+                double costToB = sum.evaluate(positions[b]), costToA = sum.evaluate(positions[a]);
+                if (costToB <= costToA)
+                    collapses.push_back({costToB, a, b});
+                else
+                    collapses.push_back({costToA, b, a});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &first, const Collapse &second)
+                  { return first.cost < second.cost; });
+
+        // Collapse the cheapest independent edges until enough triangles are removed
+        // The positions around a collapse are locked for the rest of the pass since their triangles changed
+        locked.assign(positionCount, 0);
+        for (uint32_t vertex = 0; vertex < vertices.size(); vertex++)
+            vertexRemap[vertex] = vertex;
+        size_t triangleCount = triangles.size() / 3, removed = 0, collapsed = 0;
+        for (const Collapse &collapse : collapses)
+        {
+            if (triangleCount - removed <= targetTriangleCount)
+                break;
+            uint32_t from = collapse.from, to = collapse.to;
+            if (locked[from] || locked[to])
+                continue;
+
+            // Reject the collapse if it flips any of the triangles that survive it
+            bool flips = false;
+            size_t shared = 0;
+            for (uint32_t offset = adjacencyOffsets[from]; offset < adjacencyOffsets[from + 1] && !flips; offset++)
+            {
+                uint32_t triangle = adjacency[offset];
+                uint32_t corners[3] = {positionOf[triangles[3 * triangle]], positionOf[triangles[3 * triangle + 1]], positionOf[triangles[3 * triangle + 2]]};
+                if (corners[0] == to || corners[1] == to || corners[2] == to)
+                {
+                    shared++;
+                    continue;
+                }
+                glm::dvec3 before[3], after[3];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    before[corner] = positions[corners[corner]];
+                    after[corner] = corners[corner] == from ? positions[to] : before[corner];
+                }
+                glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                flips = glm::dot(normalBefore, normalAfter) <= 0.0;
+            }
+            if (flips)
+                continue;
+
+            // Every vertex at "from" moves to the vertex at "to" with the closest attributes (so the seams are kept)
+            for (uint32_t vertex : wedges[from])
+            {
+                const Vertex &source = vertices[vertex];
+                uint32_t best = wedges[to].front();
+                float bestDistance = INFINITY;
+                for (uint32_t candidate : wedges[to])
+                {
+                    const Vertex &target = vertices[candidate];
+                    glm::vec3 normalDifference = source.normal - target.normal;
+                    glm::vec2 texCoordDifference = source.tex_coord - target.tex_coord;
+                    float distance = glm::dot(normalDifference, normalDifference) + glm::dot(texCoordDifference, texCoordDifference);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = candidate;
+                    }
+                }
+                vertexRemap[vertex] = best;
+            }
+            wedges[from].clear();
+            quadrics[to] += quadrics[from];
+
+            // Lock the one-ring of "from" (which includes "to")
+            for (uint32_t offset = adjacencyOffsets[from]; offset < adjacencyOffsets[from + 1]; offset++)
+            {
+                uint32_t triangle = adjacency[offset];
+                for (int corner = 0; corner < 3; corner++)
+                    locked[positionOf[triangles[3 * triangle + corner]]] = 1;
+            }
+            removed += shared;
+            collapsed++;
+        }
+        if (collapsed == 0)
+            break;
+
+        // Apply the collapses and drop the triangles that became degenerate
+        size_t write = 0;
+        for (size_t index = 0; index < triangles.size(); index += 3)
+        {
+            GLuint v0 = vertexRemap[triangles[index]], v1 = vertexRemap[triangles[index + 1]], v2 = vertexRemap[triangles[index + 2]];
+            uint32_t p0 = positionOf[v0], p1 = positionOf[v1], p2 = positionOf[v2];
+            if (p0 == p1 || p1 == p2 || p2 == p0)
+                continue;
+            triangles[write++] = v0;
+            triangles[write++] = v1;
+            triangles[write++] = v2;
+        }
+        triangles.resize(write);
+    }
+    return triangles;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "vertex.hpp"
+
+namespace our::mesh_utils
+{
+
+    // Simplifies a triangle list using quadric error metrics (Garland & Heckbert) by collapsing edges into one of their endpoints,
+    // so the simplified triangles only reference the given vertices and can share the vertex buffer of the original mesh.
+    // The vertices sharing a position (seams of the normals & texture coordinates) are collapsed together,
+    // the border edges are preserved by extra planes and the collapses that would flip a triangle are rejected.
+    // Returns the indices of the simplified triangles which has at most "targetTriangleCount" triangles unless no more edges can be collapsed.
+    std::vector<GLuint> simplify(const std::vector<Vertex> &vertices, const std::vector<GLuint> &elements, size_t targetTriangleCount);
+
+}
@@ -1,4 +1,6 @@
 #include "mesh-utils.hpp"
+#include "mesh-simplify.hpp"
+#include "mesh-optimize.hpp"
 
 // We will use "Tiny OBJ Loader" to read and process '.obj" files
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -8,7 +10,7 @@
 #include <vector>
 #include <unordered_map>
 
-our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename) {
+our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename, const std::vector<LODSettings>& lods, VertexFormat format, bool useArena, bool optimize) {
 
     // The data that we will use to initialize our mesh
     std::vector<our::Vertex> vertices;
@@ -81,7 +83,35 @@ our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename) {
         }
     }
 
-    return new our::Mesh(vertices, elements);
+    // Each LOD is simplified from the previous one (which is faster than starting over from the full mesh every time)
+    // and appended to the element buffer. We stop early if the simplification can't remove enough triangles.
+    std::vector<our::MeshLOD> ranges = {{0, (GLsizei)elements.size(), 0.0f}};
+    size_t triangleCount = elements.size() / 3;
+    for (size_t lod = 0; lod < lods.size() && ranges.size() < our::MAX_MESH_LODS; lod++) {
+        const MeshLOD& previous = ranges.back();
+        std::vector<GLuint> source(elements.begin() + previous.offset, elements.begin() + previous.offset + previous.count);
+        std::vector<GLuint> simplified = simplify(vertices, source, (size_t)(triangleCount * lods[lod].ratio));
+        if (simplified.size() * 10 > source.size() * 9) break;
+        ranges.push_back({(GLsizei)elements.size(), (GLsizei)simplified.size(), lods[lod].screenSize});
+        elements.insert(elements.end(), simplified.begin(), simplified.end());
+    }
+
+    // If requested, reorder the triangles of each LOD for the vertex cache then for the overdraw,
+    // then reorder the vertices in the order they are first used (the LOD ranges don't move)
+    // (the benchmarks report the ACMR gained by these passes)
+    if (optimize) {
+        for (const auto& range : ranges) {
+            std::vector<GLuint> lodElements(elements.begin() + range.offset, elements.begin() + range.offset + range.count);
+            optimizeVertexCache(lodElements, vertices.size());
+            optimizeOverdraw(lodElements, vertices);
+            std::copy(lodElements.begin(), lodElements.end(), elements.begin() + range.offset);
+        }
+        optimizeVertexFetch(vertices, elements);
+    }
+
+    auto mesh = new our::Mesh(vertices, elements, ranges, format, useArena);
+    mesh->setBounds(computeBounds(vertices));
+    return mesh;
 }
 
 // Create a sphere (the vertex order in the triangles are CCW from the outside)
@@ -119,5 +149,25 @@ our::Mesh* our::mesh_utils::sphere(const glm::ivec2& segments){
         }
     }
 
-    return new our::Mesh(vertices, elements);
-}
\ No newline at end of file
+    auto mesh = new our::Mesh(vertices, elements);
+    mesh->setBounds(computeBounds(vertices));
+    return mesh;
+}
+our::MeshBounds our::mesh_utils::computeBounds(const std::vector<our::Vertex>& vertices){
+    our::MeshBounds bounds;
+    if(vertices.empty()) return bounds;
+    bounds.min = bounds.max = vertices.front().position;
+    for(auto& vertex : vertices){
+        bounds.min = glm::min(bounds.min, vertex.position);
+        bounds.max = glm::max(bounds.max, vertex.position);
+    }
+    // The sphere is centered at the box center which is not the smallest sphere but it is tight enough for culling
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+    float radiusSquared = 0.0f;
+    for(auto& vertex : vertices){
+        glm::vec3 offset = vertex.position - bounds.center;
+        radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+    }
+    bounds.radius = glm::sqrt(radiusSquared);
+    return bounds;
+}
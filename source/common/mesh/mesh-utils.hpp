@@ -2,11 +2,23 @@
 
 #include "mesh.hpp"
 #include <string>
+#include <vector>
 
 namespace our::mesh_utils {
+    // The settings of a simplified level of detail generated while loading a mesh
+    struct LODSettings {
+        float ratio;      // The fraction of the triangles of the full mesh to keep
+        float screenSize; // The projected size below which this LOD is used (see MeshLOD)
+    };
+
     // Load an ".obj" file into the mesh
-    Mesh* loadOBJ(const std::string& filename);
+    // For each of the given LOD settings (at most MAX_MESH_LODS - 1), a simplified level of detail is appended to the element buffer
+    // The vertices are stored on the GPU in the given format (see VertexFormat), in a geometry arena if "useArena" is true
+    // If "optimize" is true, the triangles & the vertices are reordered for the GPU (see "mesh-optimize.hpp"), otherwise the order of the file is kept
+    Mesh* loadOBJ(const std::string& filename, const std::vector<LODSettings>& lods = {}, VertexFormat format = VertexFormat::FLOAT, bool useArena = false, bool optimize = false);
     // Create a sphere (the vertex order in the triangles are CCW from the outside)
     // Segments define the number of divisions on the both the latitude and the longitude
     Mesh* sphere(const glm::ivec2& segments);
+    // Computes the bounding box and the bounding sphere (around the center of the box) of the given vertices
+    MeshBounds computeBounds(const std::vector<Vertex>& vertices);
 }
\ No newline at end of file
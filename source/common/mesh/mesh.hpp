@@ -1,24 +1,70 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <glad/gl.h>
 #include "vertex.hpp"
+#include "vertex-layout.hpp"
+#include "../render-stats.hpp"
+#include "../gl-state.hpp"
+#include "instance-buffer.hpp"
+#include "geometry-arena.hpp"
 
 namespace our
 {
 
-#define ATTRIB_LOC_POSITION 0
-#define ATTRIB_LOC_COLOR 1
-#define ATTRIB_LOC_TEXCOORD 2
-#define ATTRIB_LOC_NORMAL 3
+    // The bounds of a mesh in its local space. They are used by the renderer to cull the meshes outside the camera frustum.
+    // The default bounds are unbounded (an infinite sphere) so a mesh without computed bounds is never culled.
+    struct MeshBounds
+    {
+        glm::vec3 min = glm::vec3(-INFINITY), max = glm::vec3(INFINITY); // The axis aligned bounding box
+        glm::vec3 center = glm::vec3(0.0f);                              // The center of the bounding sphere (the center of the box)
+        float radius = INFINITY;                                         // The radius of the bounding sphere
+    };
+
+    // A level of detail of a mesh: a range of the element buffer drawn while the projected size of the mesh is below "screenSize"
+    // (the fraction of the viewport height covered by the bounding sphere). The first LOD is the full mesh and is used above all thresholds.
+    struct MeshLOD
+    {
+        GLsizei offset;   // The index of the first element of the LOD
+        GLsizei count;    // The number of elements of the LOD
+        float screenSize; // The LOD is used below this projected size (ignored for the first LOD)
+    };
+
+    // The maximum number of LODs of a mesh (including the full mesh)
+    constexpr int MAX_MESH_LODS = 4;
 
     class Mesh
     {
         // Here, we store the object names of the 3 main components of a mesh:
         // A vertex array object, A vertex buffer and an element buffer
-        unsigned int VBO, EBO;
+        // (if the mesh is allocated in a geometry arena, the VAO is the arena's and the mesh owns no buffers)
+        unsigned int VBO = 0, EBO = 0;
         unsigned int VAO;
+        // The arena holding the mesh (if any) and where the mesh starts in its buffers
+        GeometryArena *arena = nullptr;
+        GLint baseVertex = 0;
+        GLsizei firstIndex = 0;
         // We need to remember the number of elements that will be draw by glDrawElements
         GLsizei elementCount;
+        // The meshes with at most 65536 vertices store 16-bit indices (GL_UNSIGNED_SHORT) which halves the element buffer
+        GLenum indexType;
+        GLsizei indexSize;
+        // The element ranges of the levels of detail (all the LODs share the vertex & element buffers)
+        std::vector<MeshLOD> lods;
+        // A small sequential ID used by the renderer sort keys to group the draws of the same mesh
+        uint32_t sortID = nextSortID++;
+        static inline uint32_t nextSortID = 0;
+        MeshBounds bounds;
+        // The format of the vertex buffer. For QUANTIZED meshes, the local position is (stored position * quantizationScale + quantizationOffset).
+        VertexFormat format;
+        glm::vec3 quantizationOffset = glm::vec3(0.0f), quantizationScale = glm::vec3(1.0f);
+        // The instance buffer & offset from which the instance attributes of the VAO currently read (see "drawInstanced")
+        // It points to the binding of the arena if the mesh shares the VAO of an arena
+        InstanceBinding ownInstanceBinding;
+        InstanceBinding *instanceBinding = &ownInstanceBinding;
 
     public:
         // The constructor takes two vectors:
@@ -28,62 +74,171 @@ namespace our
         // a vertex buffer to store the vertex data on the VRAM,
         // an element buffer to store the element data on the VRAM,
         // a vertex array object to define how to read the vertex & element buffer during rendering
-        Mesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &elements)
+        // "lods" are the ranges of the levels of detail in "elements" (if empty, the whole element buffer is the only LOD)
+        // "format" is the format in which the vertices are stored on the GPU (see VertexFormat)
+        // If "useArena" is true, the mesh is allocated in the geometry arena of its format & index type instead of owning its buffers
+        Mesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &elements, const std::vector<MeshLOD> &lods = {},
+             VertexFormat format = VertexFormat::FLOAT, bool useArena = false) : format(format)
         {
             // DONE: (Req 2) Write this function
             //  remember to store the number of elements in "elementCount" since you will need it for drawing
-            //  For the attribute locations, use the constants defined above: ATTRIB_LOC_POSITION, ATTRIB_LOC_COLOR, etc
-
-            //  vertex array:
-            glGenVertexArrays(1, &VAO);
-            glBindVertexArray(VAO);
-
-            // Vertex buffer:
-            glGenBuffers(1, &VBO);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-            // location
-            glEnableVertexAttribArray(ATTRIB_LOC_POSITION);
-            glVertexAttribPointer(ATTRIB_LOC_POSITION, 3, GL_FLOAT, false, sizeof(Vertex), (void *)0);
-
-            // color
-            glEnableVertexAttribArray(ATTRIB_LOC_COLOR);
-            glVertexAttribPointer(ATTRIB_LOC_COLOR, 4, GL_UNSIGNED_BYTE, true, sizeof(Vertex), (void *)offsetof(Vertex, color));
-
-            // tex coord
-            glEnableVertexAttribArray(ATTRIB_LOC_TEXCOORD);
-            glVertexAttribPointer(ATTRIB_LOC_TEXCOORD, 2, GL_FLOAT, false, sizeof(Vertex), (void *)offsetof(Vertex, tex_coord));
-
-            // normal
-            glEnableVertexAttribArray(ATTRIB_LOC_NORMAL);
-            glVertexAttribPointer(ATTRIB_LOC_NORMAL, 3, GL_FLOAT, false, sizeof(Vertex), (void *)offsetof(Vertex, normal));
-
-            // Element buffer:
-            glGenBuffers(1, &EBO);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * sizeof(unsigned int), elements.data(), GL_STATIC_DRAW);
+            //  For the attribute locations, use the constants defined in "vertex-layout.hpp": ATTRIB_LOC_POSITION, ATTRIB_LOC_COLOR, etc
+
+            // The quantized positions are normalized in the bounding box of the vertices (an empty axis gets a scale of 1)
+            if (format == VertexFormat::QUANTIZED && !vertices.empty())
+            {
+                glm::vec3 min = vertices[0].position, max = vertices[0].position;
+                for (const Vertex &vertex : vertices)
+                {
+                    min = glm::min(min, vertex.position);
+                    max = glm::max(max, vertex.position);
+                }
+                quantizationOffset = (min + max) * 0.5f;
+                quantizationScale = (max - min) * 0.5f;
+                for (int axis = 0; axis < 3; axis++)
+                    if (quantizationScale[axis] <= 0.0f)
+                        quantizationScale[axis] = 1.0f;
+            }
+
+            // The vertices are converted to the format & the elements to the smallest index type that can address them
+            std::vector<uint8_t> vertexData = packVertices(vertices, format, quantizationOffset, quantizationScale);
+            std::vector<GLushort> shortElements;
+            if (vertices.size() <= 65536)
+            {
+                shortElements.assign(elements.begin(), elements.end());
+                indexType = GL_UNSIGNED_SHORT;
+                indexSize = sizeof(GLushort);
+            }
+            else
+            {
+                indexType = GL_UNSIGNED_INT;
+                indexSize = sizeof(GLuint);
+            }
+            const void *indexData = indexType == GL_UNSIGNED_SHORT ? (const void *)shortElements.data() : (const void *)elements.data();
+
+            if (useArena)
+            {
+                arena = GeometryArena::get(format, indexType);
+                GeometryArena::Allocation allocation = arena->allocate(vertexData.data(), (GLsizei)vertices.size(), indexData, (GLsizei)elements.size());
+                VAO = arena->getVertexArray();
+                baseVertex = allocation.baseVertex;
+                firstIndex = allocation.firstIndex;
+                instanceBinding = &arena->getInstanceBinding();
+            }
+            else
+            {
+                //  vertex array:
+                glGenVertexArrays(1, &VAO);
+                GLState::bindVertexArray(VAO);
+
+                // Vertex buffer:
+                glGenBuffers(1, &VBO);
+                glBindBuffer(GL_ARRAY_BUFFER, VBO);
+                glBufferData(GL_ARRAY_BUFFER, vertexData.size(), vertexData.data(), GL_STATIC_DRAW);
+
+                // The position, color, tex coord & normal attributes are pointed according to the layout of the format
+                getVertexLayout(format).apply();
+
+                // Element buffer:
+                glGenBuffers(1, &EBO);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * indexSize, indexData, GL_STATIC_DRAW);
+                RenderStats::current().bytesUploaded += vertexData.size() + elements.size() * indexSize;
+            }
             // save elementCount
             elementCount = elements.size();
+            this->lods = lods;
+            if (this->lods.empty())
+                this->lods.push_back({0, elementCount, 0.0f});
+            if (this->lods.size() > MAX_MESH_LODS)
+                this->lods.resize(MAX_MESH_LODS);
         }
 
-        // this function should render the mesh
-        void draw()
+        // this function should render the mesh (at the given level of detail)
+        void draw(int lod = 0)
         {
             // Done: (Req 2) Write this function
 
             // Render the mesh
-            glBindVertexArray(VAO);
-            glDrawElements(GL_TRIANGLES, elementCount, GL_UNSIGNED_INT, (void *)0);
+            const MeshLOD &range = lods[lod];
+            GLState::bindVertexArray(VAO);
+            glDrawElementsBaseVertex(GL_TRIANGLES, range.count, indexType, (void *)(intptr_t)((firstIndex + range.offset) * indexSize), baseVertex);
+            RenderStats::current().drawCalls++;
+            RenderStats::current().triangles += range.count / 3;
+        }
+
+        // Draws "instanceCount" instances of the mesh whose data (InstanceData) starts at "offset" in the given buffer.
+        // The instance attributes are attached to the VAO of the mesh with a divisor of 1 and only re-pointed when the buffer or offset changes.
+        void drawInstanced(GLsizei instanceCount, const InstanceBuffer &buffer, GLintptr offset, int lod = 0)
+        {
+            GLState::bindVertexArray(VAO);
+            if (buffer.getID() != instanceBinding->bufferID || offset != instanceBinding->offset)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, buffer.getOpenGLName());
+                for (int column = 0; column < 4; column++)
+                {
+                    GLuint locationM = ATTRIB_LOC_INSTANCE_M + column, locationM_IT = ATTRIB_LOC_INSTANCE_M_IT + column;
+                    GLintptr columnOffset = offset + column * sizeof(glm::vec4);
+                    glVertexAttribPointer(locationM, 4, GL_FLOAT, false, sizeof(InstanceData), (void *)(columnOffset + offsetof(InstanceData, M)));
+                    glVertexAttribPointer(locationM_IT, 4, GL_FLOAT, false, sizeof(InstanceData), (void *)(columnOffset + offsetof(InstanceData, M_IT)));
+                    if (instanceBinding->bufferID == 0)
+                    {
+                        glEnableVertexAttribArray(locationM);
+                        glEnableVertexAttribArray(locationM_IT);
+                        glVertexAttribDivisor(locationM, 1);
+                        glVertexAttribDivisor(locationM_IT, 1);
+                    }
+                }
+                instanceBinding->bufferID = buffer.getID();
+                instanceBinding->offset = offset;
+            }
+            const MeshLOD &range = lods[lod];
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.count, indexType, (void *)(intptr_t)((firstIndex + range.offset) * indexSize),
+                                              instanceCount, baseVertex);
+            RenderStats::current().drawCalls++;
+            RenderStats::current().triangles += (uint64_t)(range.count / 3) * instanceCount;
+        }
+
+        uint32_t getSortID() const { return sortID; }
+
+        int getLODCount() const { return (int)lods.size(); }
+
+        // Picks the LOD for the given projected size (see MeshLOD) starting from the LOD used in the last frame.
+        // A LOD only changes once the size is past its threshold by the "hysteresis" fraction so the LOD doesn't flicker around a threshold.
+        int selectLOD(float screenSize, int previousLOD, float hysteresis) const
+        {
+            int lod = std::clamp(previousLOD, 0, (int)lods.size() - 1);
+            while (lod + 1 < (int)lods.size() && screenSize < lods[lod + 1].screenSize * (1.0f - hysteresis))
+                lod++;
+            while (lod > 0 && screenSize > lods[lod].screenSize * (1.0f + hysteresis))
+                lod--;
+            return lod;
         }
 
+        VertexFormat getFormat() const { return format; }
+        bool isQuantized() const { return format == VertexFormat::QUANTIZED; }
+        // The transformation from the stored (quantized) positions to the local space (only meaningful if the mesh is quantized)
+        glm::vec3 getQuantizationOffset() const { return quantizationOffset; }
+        glm::vec3 getQuantizationScale() const { return quantizationScale; }
+
+        const MeshBounds &getBounds() const { return bounds; }
+        void setBounds(const MeshBounds &bounds) { this->bounds = bounds; }
+
         // this function should delete the vertex & element buffers and the vertex array object
         ~Mesh()
         {
             // Done: (Req 2) Write this function
 
+            // A mesh in an arena only gives its range back (the arena owns the vertex array & the buffers)
+            if (arena)
+            {
+                arena->release();
+                return;
+            }
+
             // Delete the vertex array
             glDeleteVertexArrays(1, &VAO);
+            GLState::onVertexArrayDeleted(VAO);
 
             // Delete the buffers
             glDeleteBuffers(1, &VBO);
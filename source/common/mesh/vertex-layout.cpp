@@ -0,0 +1,125 @@
+#include "vertex-layout.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace our
+{
+
+    namespace
+    {
+        // The packed vertex formats. The members are 4-byte aligned so every attribute starts on a 4-byte boundary.
+        struct PackedVertex
+        {
+            glm::vec3 position;
+            Color color;
+            uint32_t tex_coord; // Two half floats
+            uint32_t normal;    // A signed normalized 2_10_10_10 (w is unused)
+        };
+        struct QuantizedVertex
+        {
+            int16_t position[4]; // Four 16-bit signed normalized values (w is unused)
+            Color color;
+            uint32_t tex_coord;
+            uint32_t normal;
+        };
+        static_assert(sizeof(PackedVertex) == 24 && sizeof(QuantizedVertex) == 20, "Unexpected packed vertex sizes");
+
+        template <typename T>
+        void packAttributes(const Vertex &vertex, T &packed)
+        {
+            packed.color = vertex.color;
+            packed.tex_coord = glm::packHalf2x16(vertex.tex_coord);
+            packed.normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f));
+        }
+    }
+
+    VertexFormat parseVertexFormat(const std::string &name)
+    {
+        if (name == "packed")
+            return VertexFormat::PACKED;
+        if (name == "quantized")
+            return VertexFormat::QUANTIZED;
+        return VertexFormat::FLOAT;
+    }
+
+    void VertexLayout::apply() const
+    {
+        for (const VertexAttribute &attribute : attributes)
+        {
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, stride, (void *)(intptr_t)attribute.offset);
+        }
+    }
+
+    const VertexLayout &getVertexLayout(VertexFormat format)
+    {
+        static const VertexLayout floatLayout = {
+            sizeof(Vertex),
+            {{ATTRIB_LOC_POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position)},
+             {ATTRIB_LOC_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, color)},
+             {ATTRIB_LOC_TEXCOORD, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, tex_coord)},
+             {ATTRIB_LOC_NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal)}}};
+        // The 2_10_10_10 types only accept a size of 4 (the shaders read the normal as a vec3 so w is dropped)
+        static const VertexLayout packedLayout = {
+            sizeof(PackedVertex),
+            {{ATTRIB_LOC_POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(PackedVertex, position)},
+             {ATTRIB_LOC_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(PackedVertex, color)},
+             {ATTRIB_LOC_TEXCOORD, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, tex_coord)},
+             {ATTRIB_LOC_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedVertex, normal)}}};
+        static const VertexLayout quantizedLayout = {
+            sizeof(QuantizedVertex),
+            {{ATTRIB_LOC_POSITION, 3, GL_SHORT, GL_TRUE, offsetof(QuantizedVertex, position)},
+             {ATTRIB_LOC_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(QuantizedVertex, color)},
+             {ATTRIB_LOC_TEXCOORD, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(QuantizedVertex, tex_coord)},
+             {ATTRIB_LOC_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(QuantizedVertex, normal)}}};
+        switch (format)
+        {
+        case VertexFormat::PACKED:
+            return packedLayout;
+        case VertexFormat::QUANTIZED:
+            return quantizedLayout;
+        default:
+            return floatLayout;
+        }
+    }
+
+    std::vector<uint8_t> packVertices(const std::vector<Vertex> &vertices, VertexFormat format,
+                                      glm::vec3 quantizationOffset, glm::vec3 quantizationScale)
+    {
+        std::vector<uint8_t> bytes(vertices.size() * getVertexLayout(format).stride);
+        switch (format)
+        {
+        case VertexFormat::PACKED:
+        {
+            auto packed = reinterpret_cast<PackedVertex *>(bytes.data());
+            for (size_t index = 0; index < vertices.size(); index++)
+            {
+                packed[index].position = vertices[index].position;
+                packAttributes(vertices[index], packed[index]);
+            }
+            break;
+        }
+        case VertexFormat::QUANTIZED:
+        {
+            auto quantized = reinterpret_cast<QuantizedVertex *>(bytes.data());
+            for (size_t index = 0; index < vertices.size(); index++)
+            {
+                glm::vec3 position = (vertices[index].position - quantizationOffset) / quantizationScale;
+                uint64_t packed = glm::packSnorm4x16(glm::vec4(position, 0.0f));
+                std::memcpy(quantized[index].position, &packed, sizeof(packed));
+                packAttributes(vertices[index], quantized[index]);
+            }
+            break;
+        }
+        default:
+            std::memcpy(bytes.data(), vertices.data(), bytes.size());
+            break;
+        }
+        return bytes;
+    }
+
+}
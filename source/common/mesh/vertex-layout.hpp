@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include "vertex.hpp"
+
+namespace our
+{
+
+#define ATTRIB_LOC_POSITION 0
+#define ATTRIB_LOC_COLOR 1
+#define ATTRIB_LOC_TEXCOORD 2
+#define ATTRIB_LOC_NORMAL 3
+
+    // The formats in which the vertices of a mesh can be stored on the GPU
+    enum class VertexFormat
+    {
+        FLOAT,    // The "Vertex" struct as is (36 bytes): float position, RGBA8 color, float UV & float normal
+        PACKED,   // Float position, RGBA8 color, half float UV & a 2_10_10_10 normal (24 bytes)
+        QUANTIZED // Like PACKED but the position is 16-bit normalized in the mesh bounding box (20 bytes)
+                  // The shaders dequantize it in the "QUANTIZED" variant (see "shader_variant")
+    };
+
+    // Parses a vertex format name ("float", "packed" or "quantized"). Unknown names give FLOAT.
+    VertexFormat parseVertexFormat(const std::string &name);
+
+    // How a single vertex attribute is read from the vertex buffer (the arguments of glVertexAttribPointer)
+    struct VertexAttribute
+    {
+        GLuint location;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei offset;
+    };
+
+    // A layout descriptor: the attributes of a vertex format and the size of a vertex
+    struct VertexLayout
+    {
+        GLsizei stride;
+        std::vector<VertexAttribute> attributes;
+
+        // Enables & points the attributes of the currently bound VAO to the currently bound GL_ARRAY_BUFFER
+        void apply() const;
+    };
+
+    // Returns the layout descriptor of the given format
+    const VertexLayout &getVertexLayout(VertexFormat format);
+
+    // Converts the vertices to the given format (the returned bytes follow "getVertexLayout(format)").
+    // For QUANTIZED, each position is stored as (position - offset) / scale which must be in [-1, 1].
+    std::vector<uint8_t> packVertices(const std::vector<Vertex> &vertices, VertexFormat format,
+                                      glm::vec3 quantizationOffset = glm::vec3(0.0f), glm::vec3 quantizationScale = glm::vec3(1.0f));
+
+}
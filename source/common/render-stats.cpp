@@ -0,0 +1,97 @@
+#include "render-stats.hpp"
+
+#include <imgui.h>
+#include <iomanip>
+
+namespace our
+{
+
+    RenderStats &RenderStats::operator+=(const RenderStats &other)
+    {
+        drawCalls += other.drawCalls;
+        triangles += other.triangles;
+        programSwitches += other.programSwitches;
+        stateChanges += other.stateChanges;
+        textureBinds += other.textureBinds;
+        samplerBinds += other.samplerBinds;
+        uniformCalls += other.uniformCalls;
+        bytesUploaded += other.bytesUploaded;
+        visibleCommands += other.visibleCommands;
+        culledCommands += other.culledCommands;
+        skippedCalls += other.skippedCalls;
+        lights += other.lights;
+        clusterLights += other.clusterLights;
+        scenePixels += other.scenePixels;
+        occlusionQueries += other.occlusionQueries;
+        occludedCommands += other.occludedCommands;
+        return *this;
+    }
+
+    void RenderStats::endFrame()
+    {
+        last = frame;
+        accumulated += frame;
+        ++frames;
+        frame = RenderStats();
+    }
+
+    void RenderStats::reset()
+    {
+        frame = last = accumulated = RenderStats();
+        frames = 0;
+    }
+
+    void RenderStats::printSummary(std::ostream &stream)
+    {
+        // Avoid dividing by zero if no frame was completed
+        double count = frames == 0 ? 1.0 : (double)frames;
+        auto line = [&](const char *label, uint64_t value)
+        {
+            stream << "  " << std::left << std::setw(18) << label
+                   << std::right << std::setw(14) << value
+                   << std::setw(16) << std::fixed << std::setprecision(1) << value / count << std::endl;
+        };
+        stream << "Render statistics over " << frames << " frames:" << std::endl;
+        stream << "  " << std::left << std::setw(18) << "counter"
+               << std::right << std::setw(14) << "total" << std::setw(16) << "per frame" << std::endl;
+        line("draw calls", accumulated.drawCalls);
+        line("triangles", accumulated.triangles);
+        line("program switches", accumulated.programSwitches);
+        line("state changes", accumulated.stateChanges);
+        line("texture binds", accumulated.textureBinds);
+        line("sampler binds", accumulated.samplerBinds);
+        line("uniform calls", accumulated.uniformCalls);
+        line("bytes uploaded", accumulated.bytesUploaded);
+        line("visible commands", accumulated.visibleCommands);
+        line("culled commands", accumulated.culledCommands);
+        line("skipped calls", accumulated.skippedCalls);
+        line("lights", accumulated.lights);
+        line("cluster lights", accumulated.clusterLights);
+        line("scene pixels", accumulated.scenePixels);
+        line("occlusion queries", accumulated.occlusionQueries);
+        line("occluded commands", accumulated.occludedCommands);
+    }
+
+    void RenderStats::drawImGui()
+    {
+        ImGui::Begin("Render Stats");
+        ImGui::Text("Draw calls       : %llu", (unsigned long long)last.drawCalls);
+        ImGui::Text("Triangles        : %llu", (unsigned long long)last.triangles);
+        ImGui::Text("Program switches : %llu", (unsigned long long)last.programSwitches);
+        ImGui::Text("State changes    : %llu", (unsigned long long)last.stateChanges);
+        ImGui::Text("Texture binds    : %llu", (unsigned long long)last.textureBinds);
+        ImGui::Text("Sampler binds    : %llu", (unsigned long long)last.samplerBinds);
+        ImGui::Text("Uniform calls    : %llu", (unsigned long long)last.uniformCalls);
+        ImGui::Text("Bytes uploaded   : %llu", (unsigned long long)last.bytesUploaded);
+        ImGui::Text("Visible commands : %llu", (unsigned long long)last.visibleCommands);
+        ImGui::Text("Culled commands  : %llu", (unsigned long long)last.culledCommands);
+        ImGui::Text("Skipped calls    : %llu", (unsigned long long)last.skippedCalls);
+        ImGui::Text("Lights           : %llu", (unsigned long long)last.lights);
+        ImGui::Text("Cluster lights   : %llu", (unsigned long long)last.clusterLights);
+        ImGui::Text("Scene pixels     : %llu", (unsigned long long)last.scenePixels);
+        ImGui::Text("Occlusion queries: %llu", (unsigned long long)last.occlusionQueries);
+        ImGui::Text("Occluded commands: %llu", (unsigned long long)last.occludedCommands);
+        ImGui::End();
+    }
+
+}
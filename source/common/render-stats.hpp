@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+namespace our
+{
+
+    // This struct holds counters for the OpenGL work issued by our wrappers (Mesh, ShaderProgram, PipelineState, Texture2D & Sampler through GLState).
+    // The wrappers increment the counters of the frame being recorded (see "current") and the application calls "endFrame"
+    // once per frame to archive them, so any optimization can be measured in call counts instead of guesses.
+    struct RenderStats
+    {
+        uint64_t drawCalls = 0;        // Number of glDraw* calls
+        uint64_t triangles = 0;        // Number of triangles submitted by the draw calls
+        uint64_t programSwitches = 0;  // Number of glUseProgram calls
+        uint64_t stateChanges = 0;     // Number of state calls (glEnable, glDisable, glDepthFunc, glBlendFunc, glBindVertexArray, etc.)
+        uint64_t textureBinds = 0;     // Number of glBindTexture calls
+        uint64_t samplerBinds = 0;     // Number of glBindSampler calls
+        uint64_t uniformCalls = 0;     // Number of glUniform* calls
+        uint64_t bytesUploaded = 0;    // Number of bytes sent to buffers and textures
+        uint64_t visibleCommands = 0;  // Number of render commands inside the camera frustum
+        uint64_t culledCommands = 0;   // Number of render commands skipped since they are outside the camera frustum
+        uint64_t skippedCalls = 0;     // Number of state calls skipped by GLState since they would not change anything
+        uint64_t lights = 0;           // Number of lights sent to the lit shaders
+        uint64_t clusterLights = 0;    // Number of light indices in the light lists of the clusters
+        uint64_t scenePixels = 0;      // Number of pixels of the 3D scene (less than the window with dynamic resolution)
+        uint64_t occlusionQueries = 0; // Number of bounding boxes tested with an occlusion query
+        uint64_t occludedCommands = 0; // Number of render commands only drawn if their box passes the occlusion test (they were hidden the last time)
+
+        RenderStats &operator+=(const RenderStats &other);
+
+        // Returns the counters of the frame that is currently being recorded (this is what the wrappers increment)
+        static RenderStats &current() { return frame; }
+        // Returns the counters of the last completed frame
+        static const RenderStats &lastFrame() { return last; }
+        // Returns the sum of the counters of all the completed frames since the last reset
+        static const RenderStats &total() { return accumulated; }
+        // Returns the number of completed frames since the last reset
+        static uint64_t frameCount() { return frames; }
+
+        // Archives the current frame counters into "lastFrame" & "total" then clears them for the next frame
+        static void endFrame();
+        // Clears all the counters
+        static void reset();
+        // Prints the totals and the per-frame averages of all the completed frames
+        static void printSummary(std::ostream &stream);
+        // Draws an ImGui window containing the counters of the last completed frame
+        static void drawImGui();
+
+    private:
+        static RenderStats frame, last, accumulated;
+        static inline uint64_t frames = 0;
+    };
+
+    inline RenderStats RenderStats::frame;
+    inline RenderStats RenderStats::last;
+    inline RenderStats RenderStats::accumulated;
+
+}
@@ -1,15 +1,32 @@
 #include "shader.hpp"
+#include "uniform-buffer.hpp"
 
 #include <cassert>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include <regex>
 
 // Forward definition for error checking functions
 std::string checkForShaderCompilationErrors(GLuint shader);
 std::string checkForLinkingErrors(GLuint program);
 
-bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
+std::vector<std::string> our::shader_variant::getDefines(uint32_t flags)
+{
+    std::vector<std::string> defines;
+    if (flags & INSTANCED)
+        defines.push_back("INSTANCED");
+    if (flags & QUANTIZED)
+        defines.push_back("QUANTIZED");
+    if (flags & DEPTH_ONLY)
+        defines.push_back("DEPTH_ONLY");
+    if (flags & OIT)
+        defines.push_back("OIT");
+    return defines;
+}
+
+bool our::ShaderProgram::attach(const std::string &filename, GLenum type, const std::vector<std::string> &defines)
 {
     // Here, we open the file and read a string from it containing the GLSL code of our shader
     std::ifstream file(filename);
@@ -19,8 +36,25 @@ bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
         return false;
     }
     std::string sourceString = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
-    const char *sourceCStr = sourceString.c_str();
     file.close();
+    stages.push_back({filename, type, sourceString});
+    this->defines = defines;
+
+    // The defines must come after the "#version" line (which must be the first line of the shader)
+    if (!defines.empty())
+    {
+        std::string defineLines;
+        for (auto &define : defines)
+            defineLines += "#define " + define + "\n";
+        size_t position = 0;
+        if (sourceString.compare(0, 8, "#version") == 0)
+        {
+            position = sourceString.find('\n');
+            position = position == std::string::npos ? sourceString.size() : position + 1;
+        }
+        sourceString.insert(position, defineLines);
+    }
+    const char *sourceCStr = sourceString.c_str();
 
     // DONE: Complete this function
     //  Create a new shader object and compile the shader code
@@ -50,7 +84,7 @@ bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
     return true;
 }
 
-bool our::ShaderProgram::link() const
+bool our::ShaderProgram::link()
 {
     // DONE: Complete this function
     // Note: The function "checkForLinkingErrors" checks if there is
@@ -71,9 +105,123 @@ bool our::ShaderProgram::link() const
         return false;
     }
 
+    bindUniformBlocks();
+    buildUniformTable();
     return true;
 }
 
+// Returns true if the source tests the given define (with #ifdef, #ifndef or defined(...)).
+// Only whole identifiers match so e.g. "#define POINT 1" doesn't make a shader support the OIT variant.
+static bool testsDefine(const std::string &source, const std::string &define)
+{
+    std::regex test("\\b(ifdef|ifndef|defined)\\s*\\(?\\s*" + define + "\\b");
+    return std::regex_search(source, test);
+}
+
+void our::ShaderProgram::compileVariant(uint32_t flags)
+{
+    variantsCompiled[flags] = true;
+    // A flag is supported if one of the stages tests its define
+    std::vector<std::string> variantDefines = shader_variant::getDefines(flags);
+    for (auto &define : variantDefines)
+    {
+        bool supported = std::any_of(stages.begin(), stages.end(), [&](const Stage &stage)
+                                     { return testsDefine(stage.source, define); });
+        if (!supported)
+            return;
+    }
+    // The variant keeps the defines of this program too
+    variantDefines.insert(variantDefines.begin(), defines.begin(), defines.end());
+    ShaderProgram *variant = new ShaderProgram();
+    bool success = true;
+    for (auto &stage : stages)
+        success = variant->attach(stage.filename, stage.type, variantDefines) && success;
+    if (!success || !variant->link())
+    {
+        std::cerr << "ERROR: Failed to build a variant of the shader: " << (stages.empty() ? "" : stages.front().filename) << std::endl;
+        delete variant;
+        return;
+    }
+    variants[flags] = variant;
+}
+
+void our::ShaderProgram::bindUniformBlocks()
+{
+    // Every active block that is shared between the shaders (currently only "FrameData") is bound to its fixed binding point
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for (GLint index = 0; index < count; index++)
+    {
+        GLint length = 0;
+        glGetActiveUniformBlockiv(program, (GLuint)index, GL_UNIFORM_BLOCK_NAME_LENGTH, &length);
+        std::vector<char> nameBuffer(std::max(length, 1));
+        glGetActiveUniformBlockName(program, (GLuint)index, (GLsizei)nameBuffer.size(), nullptr, nameBuffer.data());
+        GLint binding = uniform_blocks::getBinding(nameBuffer.data());
+        if (binding != -1)
+            glUniformBlockBinding(program, (GLuint)index, (GLuint)binding);
+        else
+            std::cerr << "WARNING: Unknown uniform block: " << nameBuffer.data() << std::endl;
+    }
+}
+
+void our::ShaderProgram::buildUniformTable()
+{
+    // First, we collect the names & locations of all the active uniforms
+    // Arrays of basic types are reported once (e.g. "values[0]" with size 4) so we add each element and the name without "[0]"
+    // Arrays of structs are reported per member (e.g. "lights[3].diffuse") so they need nothing special
+    std::vector<std::pair<std::string, GLint>> uniforms;
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> nameBuffer(std::max(maxLength, 1));
+    for (GLint index = 0; index < count; index++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type;
+        glGetActiveUniform(program, (GLuint)index, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+        GLint location = glGetUniformLocation(program, name.c_str());
+        // The uniforms inside uniform blocks have no location
+        if (location == -1)
+            continue;
+        uniforms.push_back({name, location});
+        if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+        {
+            std::string base = name.substr(0, name.size() - 3);
+            uniforms.push_back({base, location});
+            for (GLint element = 1; element < size; element++)
+            {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                if (GLint elementLocation = glGetUniformLocation(program, elementName.c_str()); elementLocation != -1)
+                    uniforms.push_back({elementName, elementLocation});
+            }
+        }
+    }
+
+    // Then we insert them into an open-addressed table whose size is a power of two (at least twice the uniform count)
+    size_t capacity = 1;
+    while (capacity < 2 * uniforms.size())
+        capacity <<= 1;
+    uniformSlots.assign(uniforms.empty() ? 0 : capacity, UniformSlot{});
+    for (auto &[name, location] : uniforms)
+    {
+        uint32_t hash = UniformID(name).hash;
+        size_t mask = capacity - 1;
+        size_t index = hash & mask;
+        while (uniformSlots[index].used && uniformSlots[index].hash != hash)
+            index = (index + 1) & mask;
+        if (uniformSlots[index].used)
+        {
+            std::cerr << "WARNING: Uniform name hash collision for: " << name << std::endl;
+            continue;
+        }
+        uniformSlots[index].used = true;
+        uniformSlots[index].hash = hash;
+        uniformSlots[index].location = location;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////
 // Function to check for compilation and linking error in shaders //
 ////////////////////////////////////////////////////////////////////
@@ -2,20 +2,113 @@
 #define SHADER_HPP
 
 #include <string>
+#include <vector>
+#include <cstring>
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "../render-stats.hpp"
+#include "../gl-state.hpp"
+#include "uniform-id.hpp"
+
 namespace our
 {
 
+    // The variant flags of a shader program. Each flag adds a "#define" (its name) to every stage of the program
+    // so the shader sources can opt into a variant with "#ifdef". A shader supports a flag if one of its stages tests its name
+    // as a whole identifier with "#ifdef", "#ifndef" or "defined(...)" (merely mentioning it, e.g. in another identifier, doesn't count).
+    namespace shader_variant
+    {
+        enum : uint32_t
+        {
+            NONE = 0,
+            INSTANCED = 1 << 0, // The model matrices come from per-instance attributes (see "mesh/instance-buffer.hpp")
+            QUANTIZED = 1 << 1, // The positions are dequantized with "quantization_scale" & "quantization_offset" (see VertexFormat)
+            DEPTH_ONLY = 1 << 2, // Only the depth is needed (the depth prepass) so the fragment shader can skip the shading
+            OIT = 1 << 3,        // The fragment shader writes to the targets of the weighted blended order-independent transparency
+            COUNT = 1 << 4       // The number of flag combinations
+        };
+
+        // Returns the names of the defines added for the given flags
+        std::vector<std::string> getDefines(uint32_t flags);
+    }
+
     class ShaderProgram
     {
 
     private:
         // Shader Program Handle (OpenGL object name)
         GLuint program;
+        // A small sequential ID used by the renderer sort keys (see "getSortID")
+        uint32_t sortID = nextSortID++;
+        static inline uint32_t nextSortID = 0;
+
+        // The stages attached to this program (and the defines they were compiled with) so the variants can be compiled from the same files
+        struct Stage
+        {
+            std::string filename;
+            GLenum type;
+            std::string source;
+        };
+        std::vector<Stage> stages;
+        std::vector<std::string> defines;
+        // The variants of this program (index 0 is unused since it is the program itself). They are compiled on first use.
+        ShaderProgram *variants[shader_variant::COUNT] = {};
+        bool variantsCompiled[shader_variant::COUNT] = {};
+
+        // An entry in the uniform location table. It also caches the last value sent to the uniform
+        // so setting the same value again doesn't issue a GL call.
+        struct UniformSlot
+        {
+            uint32_t hash = 0;
+            GLint location = -1;
+            bool used = false;   // Whether this slot holds a uniform (the table is open-addressed)
+            bool cached = false; // Whether "value" holds the last value sent to the uniform
+            alignas(16) unsigned char value[sizeof(glm::mat4)];
+        };
+        // The location table is built once after linking by enumerating the active uniforms.
+        // It is open-addressed (linear probing) and its size is a power of two that is at least twice the uniform count.
+        std::vector<UniformSlot> uniformSlots;
+
+        // Compiles & links the variant of the given flags (if the stages support all of them)
+        void compileVariant(uint32_t flags);
+        // Binds the active uniform blocks of the linked program to their fixed binding points (see "uniform-buffer.hpp")
+        void bindUniformBlocks();
+        // Fills the location table using the active uniforms of the linked program
+        void buildUniformTable();
+
+        UniformSlot *findUniform(UniformID uniform)
+        {
+            if (uniformSlots.empty())
+                return nullptr;
+            size_t mask = uniformSlots.size() - 1;
+            for (size_t index = uniform.hash & mask;; index = (index + 1) & mask)
+            {
+                UniformSlot &slot = uniformSlots[index];
+                if (!slot.used)
+                    return nullptr;
+                if (slot.hash == uniform.hash)
+                    return &slot;
+            }
+        }
+
+        // Returns the location to which the value should be sent or -1 if the uniform is not active or already holds this value
+        template <typename T>
+        GLint prepareUniform(UniformID uniform, const T &value)
+        {
+            static_assert(sizeof(T) <= sizeof(UniformSlot::value), "The uniform value is too big to be cached");
+            UniformSlot *slot = findUniform(uniform);
+            if (!slot)
+                return -1;
+            if (slot->cached && std::memcmp(slot->value, &value, sizeof(T)) == 0)
+                return -1;
+            std::memcpy(slot->value, &value, sizeof(T));
+            slot->cached = true;
+            RenderStats::current().uniformCalls++;
+            return slot->location;
+        }
 
     public:
         ShaderProgram()
@@ -27,63 +120,89 @@ namespace our
         {
             // DONE: (Req 1) Delete a shader program
             glDeleteProgram(program);
+            GLState::onProgramDeleted(program);
+            for (ShaderProgram *variant : variants)
+                delete variant;
         }
 
-        bool attach(const std::string &filename, GLenum type) const;
+        // Compiles the shader file and attaches it to this program. The defines are inserted after the "#version" line.
+        bool attach(const std::string &filename, GLenum type, const std::vector<std::string> &defines = {});
+
+        bool link();
+
+        // Returns the program compiled with the defines of the given variant flags (or this program if there are no flags).
+        // Returns null if the shader sources do not support one of the flags (so the caller can fall back to another path).
+        ShaderProgram *getVariant(uint32_t flags)
+        {
+            if (flags == shader_variant::NONE)
+                return this;
+            if (!variantsCompiled[flags])
+                compileVariant(flags);
+            return variants[flags];
+        }
 
-        bool link() const;
+        // Returns a small sequential ID used by the renderer sort keys to group the draws of the same shader
+        uint32_t getSortID() const { return sortID; }
 
         void use()
         {
-            glUseProgram(program);
+            GLState::useProgram(program);
         }
 
-        GLuint getUniformLocation(const std::string &name)
+        GLint getUniformLocation(UniformID uniform)
         {
             // DONE: (Req 1) Return the location of the uniform with the given name
-            return glGetUniformLocation(program, name.c_str());
+            UniformSlot *slot = findUniform(uniform);
+            return slot ? slot->location : -1;
         }
 
-        void set(const std::string &uniform, GLfloat value)
+        void set(UniformID uniform, GLfloat value)
         {
             // DONE: (Req 1) Send the given float value to the given uniform
-            return glUniform1f(getUniformLocation(uniform), value);
+            if (GLint location = prepareUniform(uniform, value); location != -1)
+                glUniform1f(location, value);
         }
 
-        void set(const std::string &uniform, GLuint value)
+        void set(UniformID uniform, GLuint value)
         {
             // DONE: (Req 1) Send the given unsigned integer value to the given uniform
-            return glUniform1ui(getUniformLocation(uniform), value);
+            if (GLint location = prepareUniform(uniform, value); location != -1)
+                glUniform1ui(location, value);
         }
 
-        void set(const std::string &uniform, GLint value)
+        void set(UniformID uniform, GLint value)
         {
             // DONE: (Req 1) Send the given integer value to the given uniform
-            return glUniform1i(getUniformLocation(uniform), value);
+            if (GLint location = prepareUniform(uniform, value); location != -1)
+                glUniform1i(location, value);
         }
 
-        void set(const std::string &uniform, glm::vec2 value)
+        void set(UniformID uniform, glm::vec2 value)
         {
             // DONE: (Req 1) Send the given 2D vector value to the given uniform
-            glUniform2fv(getUniformLocation(uniform), 1, glm::value_ptr(value));
+            if (GLint location = prepareUniform(uniform, value); location != -1)
+                glUniform2fv(location, 1, glm::value_ptr(value));
         }
 
-        void set(const std::string &uniform, glm::vec3 value)
+        void set(UniformID uniform, glm::vec3 value)
         {
             // DONE: (Req 1) Send the given 3D vector value to the given uniform
-            glUniform3fv(getUniformLocation(uniform), 1, glm::value_ptr(value));
+            if (GLint location = prepareUniform(uniform, value); location != -1)
+                glUniform3fv(location, 1, glm::value_ptr(value));
         }
 
-        void set(const std::string &uniform, glm::vec4 value)
+        void set(UniformID uniform, glm::vec4 value)
         {
             // DONE: (Req 1) Send the given 4D vector value to the given uniform
-            glUniform4fv(getUniformLocation(uniform), 1, glm::value_ptr(value));
+            if (GLint location = prepareUniform(uniform, value); location != -1)
+                glUniform4fv(location, 1, glm::value_ptr(value));
         }
 
-        void set(const std::string &uniform, glm::mat4 matrix)
+        void set(UniformID uniform, glm::mat4 matrix)
         {
             // DONE: (Req 1) Send the given matrix 4x4 value to the given uniform
-            glUniformMatrix4fv(getUniformLocation(uniform), 1, false, &matrix[0][0]);
+            if (GLint location = prepareUniform(uniform, matrix); location != -1)
+                glUniformMatrix4fv(location, 1, false, &matrix[0][0]);
         }
 
         // DONE: (Req 1) Delete the copy constructor and assignment operator.
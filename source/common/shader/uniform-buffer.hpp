@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+
+#include <glad/gl.h>
+
+#include "../render-stats.hpp"
+
+namespace our
+{
+
+    // The fixed binding points of the uniform blocks shared between the shaders.
+    // ShaderProgram::link binds every active block with one of these names to its binding point
+    // (GLSL 330 has no "binding" layout qualifier so it has to be done from the C++ side).
+    namespace uniform_blocks
+    {
+        constexpr GLuint FRAME_DATA = 0; // "FrameData": the camera, the sky and the light clusters (see ForwardRenderer::FrameData)
+
+        // Returns the binding point of the block with the given name or -1 if it is not one of the shared blocks
+        inline GLint getBinding(const std::string &name)
+        {
+            if (name == "FrameData")
+                return FRAME_DATA;
+            return -1;
+        }
+    }
+
+    // This class wraps an OpenGL uniform buffer object whose content is replaced every frame.
+    class UniformBuffer
+    {
+        GLuint buffer;
+        GLsizeiptr size;
+
+    public:
+        // Creates a buffer of "size" bytes (the size should follow the std140 layout of the block)
+        UniformBuffer(GLsizeiptr size) : size(size)
+        {
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        ~UniformBuffer()
+        {
+            glDeleteBuffers(1, &buffer);
+        }
+
+        // Replaces the first "bytes" bytes of the buffer.
+        // The old storage is orphaned first so the driver doesn't wait for the draw calls of the last frame that still read it.
+        void update(const void *data, GLsizeiptr bytes)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, bytes, data);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            RenderStats::current().bytesUploaded += bytes;
+        }
+
+        // Binds the buffer to the given binding point of the uniform blocks
+        void bind(GLuint binding) const
+        {
+            glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+        }
+
+        UniformBuffer(const UniformBuffer &) = delete;
+        UniformBuffer &operator=(const UniformBuffer &) = delete;
+    };
+
+}
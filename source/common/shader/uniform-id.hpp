@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace our
+{
+
+    // Hashes a uniform name using FNV-1a (32 bits).
+    // It is constexpr so the uniform names known at compile time can be hashed by the compiler.
+    constexpr uint32_t hashUniformName(const char *name, size_t length)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= (uint8_t)name[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    constexpr size_t uniformNameLength(const char *name)
+    {
+        size_t length = 0;
+        while (name[length] != '\0')
+            length++;
+        return length;
+    }
+
+    // A handle to a uniform that is used to look it up in the location table of a ShaderProgram.
+    // To hash the name at compile time, store the handle in a constexpr variable:
+    //  static constexpr UniformID transform("transform");
+    // A handle can also be created from a std::string at runtime (for names that are only known at runtime).
+    struct UniformID
+    {
+        uint32_t hash;
+
+        constexpr UniformID(const char *name) : hash(hashUniformName(name, uniformNameLength(name))) {}
+        UniformID(const std::string &name) : hash(hashUniformName(name.data(), name.size())) {}
+    };
+
+}
@@ -0,0 +1,215 @@
+#include "stress-scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+
+#include <glm/glm.hpp>
+
+namespace our::stress_scene
+{
+
+    void Parameters::deserialize(const nlohmann::json &data)
+    {
+        if (!data.is_object())
+            return;
+        lanes = data.value("lanes", lanes);
+        carsPerLane = data.value("carsPerLane", carsPerLane);
+        trunks = data.value("trunks", trunks);
+        coins = data.value("coins", coins);
+        lights = data.value("lights", lights);
+        transparent = data.value("transparent", transparent);
+        hierarchyDepth = data.value("hierarchyDepth", hierarchyDepth);
+        lampsPerLane = data.value("lampsPerLane", lampsPerLane);
+        headlights = data.value("headlights", headlights);
+        seed = data.value("seed", seed);
+    }
+
+    Parameters forEntityCount(int entityCount)
+    {
+        Parameters parameters;
+        parameters.lights = std::clamp(entityCount / 100, 1, 256);
+        parameters.transparent = entityCount / 20;
+        parameters.trunks = entityCount / 20;
+        parameters.coins = entityCount / 10;
+        // The rest of the budget goes to the lanes (see "countEntities" for the size of a lane)
+        Parameters noLanes = parameters;
+        noLanes.lanes = 0;
+        int remaining = entityCount - countEntities(noLanes);
+        Parameters oneLane = parameters;
+        oneLane.lanes = 1;
+        int laneSize = countEntities(oneLane) - countEntities(noLanes);
+        parameters.lanes = std::max(1, remaining / laneSize);
+        return parameters;
+    }
+
+    int countEntities(const Parameters &parameters)
+    {
+        int depth = std::max(1, parameters.hierarchyDepth);
+        // The camera and the ground are always there
+        // Each lane has its hierarchy, its lamps and its cars where each car has 4 tires (and 2 headlights if enabled)
+        int carSize = 5 + (parameters.headlights ? 2 : 0);
+        return 2 + parameters.lanes * (depth + parameters.lampsPerLane + carSize * parameters.carsPerLane) +
+               parameters.trunks + parameters.coins + parameters.lights + parameters.transparent;
+    }
+
+    // A helper to create a json entity using the same keys as the level files
+    static nlohmann::json entity(const std::string &name, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale)
+    {
+        nlohmann::json data = {
+            {"position", {position.x, position.y, position.z}},
+            {"rotation", {rotation.x, rotation.y, rotation.z}},
+            {"scale", {scale.x, scale.y, scale.z}},
+            {"components", nlohmann::json::array()}};
+        if (!name.empty())
+            data["name"] = name;
+        return data;
+    }
+
+    static nlohmann::json meshRenderer(const std::string &mesh, const std::string &material)
+    {
+        return {{"type", "Mesh Renderer"}, {"mesh", mesh}, {"material", material}};
+    }
+
+    nlohmann::json generate(const Parameters &parameters)
+    {
+        std::mt19937 generator(parameters.seed);
+        nlohmann::json world = nlohmann::json::array();
+
+        // The lanes are laid on a square grid where each cell is as big as a road of the game (20x10 units) plus some margin
+        const glm::vec2 cellSize = {22.0f, 12.0f};
+        int columns = std::max(1, (int)std::ceil(std::sqrt((float)parameters.lanes)));
+        int rows = std::max(1, (parameters.lanes + columns - 1) / columns);
+        glm::vec2 extent = cellSize * glm::vec2(columns, rows);
+        std::uniform_real_distribution<float> randomX(-extent.x / 2, extent.x / 2);
+        std::uniform_real_distribution<float> randomZ(-extent.y / 2, extent.y / 2);
+
+        // A camera looking down at the whole grid
+        float distance = std::max(extent.x, extent.y);
+        auto camera = entity("", {0, distance * 0.5f, distance * 0.6f}, {-40, 0, 0}, {1, 1, 1});
+        camera["components"].push_back({{"type", "Camera"}, {"far", distance * 4.0f}});
+        camera["components"].push_back({{"type", "Free Camera Controller"}});
+        world.push_back(camera);
+
+        // The ground under everything
+        auto ground = entity("", {0, -1, 0}, {-90, 0, 0}, {extent.x / 2, extent.y / 2, 1});
+        ground["components"].push_back(meshRenderer("plane", "grass"));
+        world.push_back(ground);
+
+        // The lanes where each lane is a road holding a chain of pivots and the cars are attached to the last pivot
+        int carID = 1;
+        for (int lane = 0; lane < parameters.lanes; lane++)
+        {
+            glm::vec2 cell = cellSize * glm::vec2(lane % columns + 0.5f, lane / columns + 0.5f) - extent / 2.0f;
+            auto road = entity("", {cell.x, -0.999f, cell.y}, {-90, 0, 90}, {5, 10, 1});
+            road["components"].push_back(meshRenderer("plane", "road"));
+
+            // Build the cars of this lane (same transforms and components as the cars of the game levels)
+            nlohmann::json cars = nlohmann::json::array();
+            for (int car = 0; car < parameters.carsPerLane; car++)
+            {
+                float x = -0.9f + 1.8f * (car + 0.5f) / parameters.carsPerLane;
+                // Cars come in pairs where one is waiting at the start and the other is already moving
+                bool moving = car % 2 == 1;
+                auto carEntity = entity("car", {x, moving ? 0.5f : 1.2f, 0}, {90, 90, 90}, {0.3f, 1, 0.1f});
+                carEntity["components"].push_back(meshRenderer("car", "car"));
+                carEntity["components"].push_back({{"type", "Movement"},
+                                                   {"name", "car"},
+                                                   {"id", std::to_string(carID++)},
+                                                   {"linearVelocity", {0, moving ? -0.1f : 0.0f, 0}}});
+                carEntity["children"] = nlohmann::json::array();
+                for (glm::vec2 tire : {glm::vec2(-0.5f, -1), glm::vec2(0.5f, -1), glm::vec2(0.5f, 0.9f), glm::vec2(-0.5f, 0.9f)})
+                {
+                    auto tireEntity = entity("", {tire.x, 0.3f, tire.y}, {0, 0, 0}, {0.3f, 0.3f, 0.3f});
+                    tireEntity["components"].push_back(meshRenderer("tire", "tire"));
+                    tireEntity["components"].push_back({{"type", "Movement"}, {"name", "tire"}});
+                    carEntity["children"].push_back(tireEntity);
+                }
+                // The headlights are at the front of the car (the cars move along their local -y axis)
+                if (parameters.headlights)
+                    for (float side : {-0.4f, 0.4f})
+                    {
+                        auto headlight = entity("", {side, -1.1f, 0.3f}, {0, 0, 0}, {1, 1, 1});
+                        headlight["components"].push_back({{"type", "Light"},
+                                                           {"lightType", "spot"},
+                                                           {"direction", {0, -1, 0}},
+                                                           {"diffuse", {1.0f, 0.95f, 0.8f}},
+                                                           {"specular", {0.5f, 0.5f, 0.4f}},
+                                                           {"attenuation", {0.5f, 0.0f, 1.0f}},
+                                                           {"cone_angles", {0.3f, 0.5f}}});
+                        carEntity["children"].push_back(headlight);
+                    }
+                cars.push_back(carEntity);
+            }
+
+            // Wrap the cars with the pivots (the road itself is the first level of the hierarchy)
+            nlohmann::json children = cars;
+            for (int level = 1; level < parameters.hierarchyDepth; level++)
+            {
+                auto pivot = entity("", {0, 0, 0}, {0, 0, 0}, {1, 1, 1});
+                pivot["children"] = children;
+                children = nlohmann::json::array({pivot});
+            }
+            road["children"] = children;
+            world.push_back(road);
+
+            // The street lamps are spread along the side of the lane
+            for (int lamp = 0; lamp < parameters.lampsPerLane; lamp++)
+            {
+                float x = cell.x + cellSize.x * 0.9f * ((lamp + 0.5f) / parameters.lampsPerLane - 0.5f);
+                auto lampEntity = entity("", {x, 3, cell.y - cellSize.y * 0.45f}, {0, 0, 0}, {1, 1, 1});
+                lampEntity["components"].push_back({{"type", "Light"},
+                                                    {"lightType", "point"},
+                                                    {"diffuse", {1.0f, 0.8f, 0.5f}},
+                                                    {"specular", {0.5f, 0.4f, 0.25f}},
+                                                    {"attenuation", {0.2f, 0.0f, 1.0f}}});
+                world.push_back(lampEntity);
+            }
+        }
+
+        // Trunks that move left & right (the movement system keeps them in the range [-8, 8] on the x-axis)
+        std::uniform_real_distribution<float> trunkX(-8.0f, 8.0f);
+        for (int trunk = 0; trunk < parameters.trunks; trunk++)
+        {
+            auto trunkEntity = entity("trunkWood", {trunkX(generator), -0.999f, randomZ(generator)}, {0, 90, 0}, {2, 0.75f, 1.5f});
+            trunkEntity["components"].push_back(meshRenderer("trunkWood", "trunkWoodMaterial"));
+            trunkEntity["components"].push_back({{"type", "Movement"}, {"name", "trunkWood"}, {"linearVelocity", {2, 0, 0}}});
+            world.push_back(trunkEntity);
+        }
+
+        // Spinning coins
+        for (int coin = 0; coin < parameters.coins; coin++)
+        {
+            auto coinEntity = entity("coin", {randomX(generator), 0, randomZ(generator)}, {0, 90, 0}, {0.5f, 0.5f, 0.5f});
+            coinEntity["components"].push_back(meshRenderer("coin", "coinMaterial"));
+            coinEntity["components"].push_back({{"type", "Movement"}, {"name", "coin"}, {"angularVelocity", {0, 100, 0}}});
+            world.push_back(coinEntity);
+        }
+
+        // Point lights floating above the lanes
+        for (int light = 0; light < parameters.lights; light++)
+        {
+            auto lightEntity = entity("", {randomX(generator), 2, randomZ(generator)}, {0, 0, 0}, {0.2f, 0.2f, 0.2f});
+            lightEntity["components"].push_back(meshRenderer("sphere", "moon"));
+            lightEntity["components"].push_back({{"type", "Light"},
+                                                 {"lightType", "point"},
+                                                 {"diffuse", {0.8f, 0.7f, 0.5f}},
+                                                 {"specular", {0.4f, 0.35f, 0.25f}},
+                                                 {"attenuation", {0.05f, 0.0f, 1.0f}}});
+            world.push_back(lightEntity);
+        }
+
+        // Standing glass panels
+        std::uniform_real_distribution<float> randomAngle(0.0f, 180.0f);
+        for (int panel = 0; panel < parameters.transparent; panel++)
+        {
+            auto panelEntity = entity("", {randomX(generator), 0, randomZ(generator)}, {0, randomAngle(generator), 0}, {1, 1, 1});
+            panelEntity["components"].push_back(meshRenderer("plane", "glass"));
+            world.push_back(panelEntity);
+        }
+
+        return world;
+    }
+
+}
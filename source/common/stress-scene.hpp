@@ -0,0 +1,36 @@
+#pragma once
+
+#include <json/json.hpp>
+
+namespace our::stress_scene
+{
+
+    // The parameters of a generated stress scene
+    // The scene is a grid of road lanes (each lane is the root of a hierarchy holding its cars and their tires),
+    // with trunks, coins, point lights and transparent glass panels scattered over it.
+    // The lanes can also get street lamps (point lights) along their side and the cars can get headlights (two spot lights each).
+    struct Parameters
+    {
+        int lanes = 8;          // Number of road lanes
+        int carsPerLane = 4;    // Number of cars in each lane (each car has 4 tires as children)
+        int trunks = 8;         // Number of moving trunks
+        int coins = 16;         // Number of spinning coins
+        int lights = 4;         // Number of point lights (each light is drawn as a small sphere)
+        int transparent = 8;    // Number of transparent glass panels
+        int hierarchyDepth = 2; // Number of entities between the root of a lane and its cars (including the lane itself)
+        int lampsPerLane = 0;   // Number of street lamps along each lane (lights without a mesh)
+        bool headlights = false; // Whether each car gets two headlights (spot lights without a mesh)
+        unsigned int seed = 1;  // The seed of the random placement so the same parameters always give the same scene
+
+        // Reads the parameters from a json object (missing keys keep their current values)
+        void deserialize(const nlohmann::json &data);
+    };
+
+    // Picks parameters such that the generated scene has approximately "entityCount" entities
+    Parameters forEntityCount(int entityCount);
+    // Returns the exact number of entities that "generate" would create for the given parameters
+    int countEntities(const Parameters &parameters);
+    // Generates a world (in the same json schema as the worlds in "config/game.jsonc") using the meshes & materials of the game
+    nlohmann::json generate(const Parameters &parameters);
+
+}
@@ -0,0 +1,94 @@
+#include "dynamic-resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <GLFW/glfw3.h>
+
+namespace our
+{
+
+    void DynamicResolution::initialize(const nlohmann::json &config)
+    {
+        enabled = config.is_object() || (config.is_boolean() && config.get<bool>());
+        if (!enabled)
+            return;
+        if (config.is_object())
+        {
+            targetFrameTime = config.value("targetFrameTime", targetFrameTime);
+            minScale = std::clamp(config.value("minScale", minScale), 0.1f, 1.0f);
+            maxScale = std::clamp(config.value("maxScale", maxScale), minScale, 1.0f);
+            maxStep = config.value("maxStep", maxStep);
+        }
+        scale = maxScale;
+        frameTime = -1.0f;
+
+        // A timestamp counter with no bits means the timer queries are not supported
+        GLint bits = 0;
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+        timerQueries = bits > 0;
+        if (timerQueries)
+            glGenQueries(2 * QUERY_FRAMES, &queries[0][0]);
+    }
+
+    void DynamicResolution::destroy()
+    {
+        if (timerQueries)
+            glDeleteQueries(2 * QUERY_FRAMES, &queries[0][0]);
+        timerQueries = false;
+        std::fill(std::begin(pending), std::end(pending), false);
+    }
+
+    void DynamicResolution::begin()
+    {
+        if (!enabled)
+            return;
+        if (!timerQueries)
+        {
+            // Without timer queries, the whole frame time (including the swap) is measured on the CPU
+            double now = glfwGetTime();
+            if (lastCPUTime >= 0.0)
+                update((float)((now - lastCPUTime) * 1000.0));
+            lastCPUTime = now;
+            return;
+        }
+        // The slot of this frame is reused so its last result is read first (if it is still pending, it is dropped)
+        int slot = frame % QUERY_FRAMES;
+        if (pending[slot])
+        {
+            GLint ready = GL_FALSE;
+            glGetQueryObjectiv(queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &ready);
+            if (ready)
+            {
+                GLuint64 start = 0, end = 0;
+                glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end);
+                update((float)((end - start) / 1e6));
+            }
+            pending[slot] = false;
+        }
+        glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+    }
+
+    void DynamicResolution::end()
+    {
+        if (!enabled || !timerQueries)
+            return;
+        int slot = frame % QUERY_FRAMES;
+        glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+        pending[slot] = true;
+        frame++;
+    }
+
+    void DynamicResolution::update(float milliseconds)
+    {
+        frameTime = frameTime < 0.0f ? milliseconds : glm::mix(frameTime, milliseconds, 0.1f);
+        // Small errors are ignored so the scale settles instead of oscillating around the target
+        float ratio = targetFrameTime / std::max(frameTime, 1e-3f);
+        if (std::abs(ratio - 1.0f) < 0.05f)
+            return;
+        float desired = scale * std::sqrt(ratio);
+        scale = std::clamp(std::clamp(desired, scale - maxStep, scale + maxStep), minScale, maxScale);
+    }
+
+}
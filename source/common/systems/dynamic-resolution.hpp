@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+namespace our
+{
+
+    // Picks the resolution scale of the 3D scene so the frame time stays close to a target.
+    // The measured time is the GPU time of the frame's rendering (between "begin" & "end", which surround all the passes of the renderer
+    // including the postprocessing) using timestamp queries that are read a few frames later, or the CPU time between two frames
+    // if the driver has no timer queries. Since the cost of the scene grows with the number of pixels,
+    // the scale follows the square root of (target time / measured time), smoothed & clamped to [minScale, maxScale].
+    class DynamicResolution
+    {
+        static constexpr int QUERY_FRAMES = 4;
+
+        bool enabled = false;
+        float targetFrameTime = 1000.0f / 60.0f; // In milliseconds
+        float minScale = 0.5f, maxScale = 1.0f;
+        // The largest change of the scale per frame (so the resolution doesn't jump around)
+        float maxStep = 0.05f;
+        float scale = 1.0f;
+        // The smoothed frame time (in milliseconds) or a negative number if nothing was measured yet
+        float frameTime = -1.0f;
+
+        bool timerQueries = false;
+        GLuint queries[QUERY_FRAMES][2] = {};
+        bool pending[QUERY_FRAMES] = {};
+        int frame = 0;
+        double lastCPUTime = -1.0;
+
+        void update(float milliseconds);
+
+    public:
+        // Reads the config (e.g. "dynamicResolution": { "targetFrameTime": 16.6, "minScale": 0.5, "maxScale": 1.0 })
+        void initialize(const nlohmann::json &config);
+        void destroy();
+
+        bool isEnabled() const { return enabled; }
+        // Returns the resolution scale of the current frame (always 1 when disabled)
+        float getScale() const { return enabled ? scale : 1.0f; }
+        // Returns the size of the scene for the given window size
+        glm::ivec2 getRenderSize(glm::ivec2 windowSize) const
+        {
+            return glm::max(glm::ivec2(glm::vec2(windowSize) * getScale() + 0.5f), glm::ivec2(1));
+        }
+        // Returns the smoothed frame time (in milliseconds) the controller is reacting to
+        float getFrameTime() const { return frameTime; }
+
+        // Called around all the rendering of every frame
+        void begin();
+        void end();
+    };
+
+}
@@ -1,15 +1,94 @@
 #include "forward-renderer.hpp"
 #include "../mesh/mesh-utils.hpp"
 #include "../texture/texture-utils.hpp"
+#include "../deserialize-utils.hpp"
+
+#include <cmath>
+#include <cstddef>
 
 namespace our
 {
 
+    // The uniforms set by the renderer (hashed at compile time)
+    namespace uniforms
+    {
+        static constexpr UniformID transform("transform");
+        static constexpr UniformID M("M");
+        static constexpr UniformID M_IT("M_IT");
+        static constexpr UniformID quantization_scale("quantization_scale");
+        static constexpr UniformID quantization_offset("quantization_offset");
+        static constexpr UniformID light_data("light_data");
+        static constexpr UniformID light_clusters("light_clusters");
+        static constexpr UniformID light_indices("light_indices");
+        static constexpr UniformID accum("accum");
+        static constexpr UniformID weights("weights");
+    }
+
+    // Adds the variant flags needed by the vertex format of the mesh to "flags".
+    // If the shader has no quantized variant, the quantized mesh is drawn without dequantization (in its normalized bounding box).
+    static uint32_t getMeshVariant(const Material *material, const Mesh *mesh, uint32_t flags)
+    {
+        if (mesh->isQuantized() && material->shader->getVariant(flags | shader_variant::QUANTIZED))
+            flags |= shader_variant::QUANTIZED;
+        return flags;
+    }
+
+    // Sends the dequantization of the mesh positions to the shader (the uniforms are ignored by the shaders that don't use them)
+    static void setMeshUniforms(ShaderProgram *shader, const Mesh *mesh)
+    {
+        if (!mesh->isQuantized())
+            return;
+        shader->set(uniforms::quantization_scale, mesh->getQuantizationScale());
+        shader->set(uniforms::quantization_offset, mesh->getQuantizationOffset());
+    }
+
+    // Points the light samplers of a lit shader to the texture units of the light buffer textures
+    static void setLightUniforms(ShaderProgram *shader)
+    {
+        shader->set(uniforms::light_data, light_units::DATA);
+        shader->set(uniforms::light_clusters, light_units::CLUSTERS);
+        shader->set(uniforms::light_indices, light_units::INDICES);
+    }
+
     void ForwardRenderer::initialize(glm::ivec2 windowSize, const nlohmann::json &config)
     {
         // First, we store the window size for later use
         this->windowSize = windowSize;
 
+        // Create the uniform buffers shared by the lit draws
+        frameDataBuffer = new UniformBuffer(sizeof(FrameData));
+
+        // The lights are read from buffer textures: the light data, the light list range of each cluster & the light lists.
+        // The size of the cluster grid can be changed in the config (e.g. "clusters": [16, 9, 24]).
+        lightDataBuffer = new TextureBuffer(GL_RGBA32F);
+        lightClusterBuffer = new TextureBuffer(GL_RG32UI);
+        lightIndexBuffer = new TextureBuffer(GL_R16UI);
+        if (config.contains("clusters"))
+            for (auto &packet : packets)
+                packet.lightClusters.setGridSize(config["clusters"].get<glm::ivec3>());
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        maxLightIndices = (size_t)maxTexels;
+
+        // Commands sharing a mesh & a material are drawn as a single instanced draw unless instancing is disabled in the config
+        instancing = config.value("instancing", true);
+        minInstances = std::max(config.value("minInstances", 2), 1);
+        // The commands outside the camera frustum are skipped unless culling is disabled in the config
+        culling = config.value("culling", true);
+        // The LODs of the meshes are picked from their projected size unless it is disabled in the config
+        lodSelection = config.value("lod", true);
+        lodHysteresis = config.value("lodHysteresis", 0.1f);
+        // The depth prepass & the GPU timers of the passes are off unless they are enabled in the config
+        depthPrepass = config.value("depthPrepass", false);
+        passTimers.setEnabled(config.value("gpuTimers", false));
+        // The packets are prepared on a worker thread (while the previous frame is drawn) only if it is enabled in the config
+        pipelining = config.value("pipelining", false);
+        if (pipelining)
+            packetWorker.launch();
+        // The hidden opaque objects are only skipped if the occlusion culling is enabled in the config
+        occlusion.initialize(config.value("occlusionCulling", nlohmann::json(false)));
+        instanceBuffer = new InstanceBuffer();
+
         // Then we check if there is a sky texture in the configuration
         if (config.contains("sky"))
         {
@@ -62,56 +141,76 @@ namespace our
             this->skyMaterial->transparent = false;
         }
 
+        // The passes of each frame are declared in a render graph whose transient textures come from the target pool
+        graph.initialize(&targetPool);
+
         // Then we check if there is a postprocessing shader in the configuration
         if (config.contains("postprocess"))
         {
-            // DONE: (Req 11) Create a framebuffer
-            glGenFramebuffers(1, &postprocessFrameBuffer);
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, postprocessFrameBuffer);
-
-            // DONE: (Req 11) Create a color and a depth texture and attach them to the framebuffer
-            //  Hints: The color format can be (Red, Green, Blue and Alpha components with 8 bits for each channel).
-            //  The depth format can be (Depth component with 24 bits).
-            colorTarget = texture_utils::empty(GL_RGBA8, this->windowSize);
-            depthTarget = texture_utils::empty(GL_DEPTH_COMPONENT24, this->windowSize);
-
-            // Attach the color buffer texture to the framebuffer
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTarget->getOpenGLName(), 0);
-            // Attach the depth buffer renderbuffer to the framebuffer
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTarget->getOpenGLName(), 0);
-
-            // DONE: (Req 11) Unbind the framebuffer just to be safe
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // The color & the depth of the scene are transient textures of the render graph
+            // (RGBA8 for the color and a 24-bit depth, see "submitPacket")
 
             // Create a vertex array to use for drawing the texture
             glGenVertexArrays(1, &postProcessVertexArray);
 
-            // Create a sampler to use for sampling the scene texture in the post processing shader
-            Sampler *postprocessSampler = new Sampler();
-            postprocessSampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            postprocessSampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            postprocessSampler->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            postprocessSampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-            // Create the post processing shader
-            ShaderProgram *postprocessShader = new ShaderProgram();
-            postprocessShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
-            postprocessShader->attach(config.value<std::string>("postprocess", ""), GL_FRAGMENT_SHADER);
-            postprocessShader->link();
-
-            // Create a post processing material
-            postprocessMaterial = new TexturedMaterial();
-            postprocessMaterial->shader = postprocessShader;
-            postprocessMaterial->texture = colorTarget;
-            postprocessMaterial->sampler = postprocessSampler;
-            // The default options are fine but we don't need to interact with the depth buffer
-            // so it is more performant to disable the depth mask
-            postprocessMaterial->pipelineState.depthMask = false;
+            // Compile the effects (see PostprocessChain for the format of the config). Their targets come from the same pool as the graph.
+            postprocess = new PostprocessChain();
+            postprocess->initialize(config["postprocess"], &targetPool);
+        }
+
+        // The dynamic resolution needs the postprocessing to upscale the scene
+        if (config.contains("dynamicResolution"))
+        {
+            if (postprocess)
+                dynamicResolution.initialize(config["dynamicResolution"]);
+            else
+                std::cerr << "The dynamic resolution needs the postprocessing (it is disabled)" << std::endl;
+        }
+
+        // The order-independent transparency draws to its own targets but shares the depth of the scene
+        // (so the opaque objects hide the transparent fragments behind them) which is only a texture with the postprocessing
+        oit = config.value("oit", false);
+        if (oit && !postprocess)
+        {
+            std::cerr << "The order-independent transparency needs the postprocessing (it is disabled)" << std::endl;
+            oit = false;
+        }
+        if (oit)
+        {
+            oitCompositeShader = new ShaderProgram();
+            oitCompositeShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+            oitCompositeShader->attach("assets/shaders/oit-composite.frag", GL_FRAGMENT_SHADER);
+            oitCompositeShader->link();
+            // The resolved color is blended over the scene with its coverage (1 - revealage) as its alpha
+            oitCompositeState.depthMask = false;
+            oitCompositeState.blending.enabled = true;
         }
     }
 
     void ForwardRenderer::destroy()
     {
+        // The worker may still be preparing a packet
+        packetWorker.stop();
+        for (auto &packet : packets)
+            packet.valid = false;
+        lastPacket = nullptr;
+        delete frameDataBuffer;
+        frameDataBuffer = nullptr;
+        delete lightDataBuffer;
+        delete lightClusterBuffer;
+        delete lightIndexBuffer;
+        lightDataBuffer = lightClusterBuffer = lightIndexBuffer = nullptr;
+        delete instanceBuffer;
+        instanceBuffer = nullptr;
+        passTimers.destroy();
+        dynamicResolution.destroy();
+        occlusion.destroy();
+        // Delete all objects related to the order-independent transparency
+        if (oitCompositeShader)
+        {
+            delete oitCompositeShader;
+            oitCompositeShader = nullptr;
+        }
         // Delete all objects related to the sky
         if (skyMaterial)
         {
@@ -122,60 +221,81 @@ namespace our
             delete skyMaterial;
         }
         // Delete all objects related to post processing
-        if (postprocessMaterial)
+        if (postprocess)
         {
-            glDeleteFramebuffers(1, &postprocessFrameBuffer);
             glDeleteVertexArrays(1, &postProcessVertexArray);
-            delete colorTarget;
-            delete depthTarget;
-            delete postprocessMaterial->sampler;
-            delete postprocessMaterial->shader;
-            delete postprocessMaterial;
+            GLState::onVertexArrayDeleted(postProcessVertexArray);
+            postprocess->destroy();
+            delete postprocess;
+            postprocess = nullptr;
         }
+        // The framebuffers of the graph then the transient targets (shared by the graph & the postprocessing)
+        graph.destroy();
+        targetPool.clear();
     }
 
-    void ForwardRenderer::render(World *world)
+    bool ForwardRenderer::setPostprocessEffect(const std::string &effect)
+    {
+        return postprocess && postprocess->setEffect(effect);
+    }
+
+    void ForwardRenderer::resetPostprocessEffect()
+    {
+        if (postprocess)
+            postprocess->resetEffect();
+    }
+
+    CameraComponent *ForwardRenderer::extractPacket(World *world, RenderPacket &packet)
     {
         // First of all, we search for a camera and for all the mesh renderers
         CameraComponent *camera = nullptr;
-        opaqueCommands.clear();
-        transparentCommands.clear();
+        packet.valid = false;
+        packet.candidates.clear();
+        packet.candidateSpheres.clear();
+        packet.candidateQueues.clear();
+        candidateRenderers.clear();
         lightComponents.clear();
+        if (occlusion.isEnabled())
+            occlusion.beginFrame();
         for (auto entity : world->getEntities())
         {
             // If we hadn't found a camera yet, we look for a camera in this entity
             if (!camera)
                 camera = entity->getComponent<CameraComponent>();
+            // Every light is collected (whether its entity is drawn or not)
+            if (auto light = entity->getComponent<LightComponent>(); light)
+                lightComponents.push_back(light);
             // If this entity has a mesh renderer component
             if (auto meshRenderer = entity->getComponent<MeshRendererComponent>(); meshRenderer)
             {
-                // if this component has a light component, we add it to the light components list
-                if (auto light = entity->getComponent<LightComponent>(); light)
-                {
-                    lightComponents.push_back(light);
-                }
                 // We construct a command from it
                 RenderCommand command;
                 command.localToWorld = meshRenderer->getOwner()->getLocalToWorldMatrix();
-                command.center = glm::vec3(command.localToWorld * glm::vec4(0, 0, 0, 1));
                 command.mesh = meshRenderer->mesh;
                 command.material = meshRenderer->material;
-                // if it is transparent, we add it to the transparent commands list
+                command.lod = 0;
+                command.occlusionSlot = OcclusionCulling::NO_SLOT;
+                // The bounding sphere of the mesh is moved to world space (the radius is scaled by the largest axis scale)
+                const MeshBounds &bounds = command.mesh->getBounds();
+                command.center = glm::vec3(command.localToWorld * glm::vec4(bounds.center, 1));
+                float scale = std::max({glm::length(glm::vec3(command.localToWorld[0])),
+                                        glm::length(glm::vec3(command.localToWorld[1])),
+                                        glm::length(glm::vec3(command.localToWorld[2]))});
+                packet.candidateSpheres.push(command.center, std::isinf(bounds.radius) ? bounds.radius : bounds.radius * scale);
+                // if it is transparent, it goes to the transparent commands (or to the OIT commands if the OIT is enabled and its shader supports it)
+                // The shader variant is looked up here since it may have to be compiled (which can only be done on the main thread)
+                RenderQueue queue = RenderQueue::OPAQUE_COMMANDS;
                 if (command.material->transparent)
-                {
-                    transparentCommands.push_back(command);
-                }
-                else
-                {
-                    // Otherwise, we add it to the opaque command list
-                    opaqueCommands.push_back(command);
-                }
+                    queue = oit && command.material->shader->getVariant(shader_variant::OIT) ? RenderQueue::OIT_COMMANDS : RenderQueue::TRANSPARENT_COMMANDS;
+                packet.candidateQueues.push_back(queue);
+                packet.candidates.push_back(command);
+                candidateRenderers.push_back(meshRenderer);
             }
         }
 
         // If there is no camera, we return (we cannot render without a camera)
         if (camera == nullptr)
-            return;
+            return nullptr;
 
         // DONE: (Req 9) Modify the following line such that "cameraForward" contains a vector pointing the camera forward direction
         //  HINT: See how you wrote the CameraComponent::getViewMatrix, it should help you solve this one
@@ -187,263 +307,614 @@ namespace our
         auto M = camera->getOwner()->getLocalToWorldMatrix(); //? get local matrix
         glm::vec3 centerTransparency = M * glm::vec4(0.0, 0.0, -1.0, 1.0);
         glm::vec3 eyeTransparency = M * glm::vec4(0.0, 0.0, 0.0, 1.0);
-        glm::vec3 cameraForward = glm::normalize(centerTransparency - eyeTransparency);
-        std::sort(transparentCommands.begin(), transparentCommands.end(), [cameraForward](const RenderCommand &first, const RenderCommand &second)
-                  {
-            //DONE: (Req 9) Finish this function
-            // HINT: the following return should return true "first" should be drawn before "second".
-            //? Sorting the transparent rendering commands based on their distance from the camera's position along its forward direction.
-            return (glm::dot(cameraForward,first.center)>glm::dot(cameraForward,second.center) ); });
+        packet.eye = eyeTransparency;
+        packet.forward = glm::normalize(centerTransparency - eyeTransparency);
+        packet.V = camera->getViewMatrix();
+        packet.P = camera->getProjectionMatrix(this->windowSize);
+        packet.perspective = camera->cameraType == CameraType::PERSPECTIVE;
+        packet.near = camera->near;
+        packet.far = camera->far;
+        // The scale picked by the dynamic resolution from the last frames sets the size of the scene (the aspect ratio is kept)
+        packet.renderSize = dynamicResolution.getRenderSize(windowSize);
+
+        //? The projected size of a command (the fraction of the viewport height covered by its bounding sphere) picks its level of detail
+        //? (it is picked here for all the commands since the hysteresis is kept in the mesh renderers)
+        float sizeScale = packet.perspective ? 1.0f / std::tan(camera->fovY * 0.5f) : 2.0f / camera->orthoHeight;
+        for (size_t index = 0; index < packet.candidates.size(); index++)
+        {
+            RenderCommand &command = packet.candidates[index];
+            if (lodSelection && command.mesh->getLODCount() > 1)
+            {
+                float screenSize = packet.candidateSpheres.radius[index] * sizeScale;
+                if (packet.perspective)
+                    screenSize /= std::max(glm::dot(packet.forward, command.center - packet.eye), camera->near);
+                MeshRendererComponent *renderer = candidateRenderers[index];
+                renderer->lod = command.mesh->selectLOD(screenSize, renderer->lod, lodHysteresis);
+                command.lod = renderer->lod;
+            }
+        }
 
-        // DONE: (Req 9) Get the camera ViewProjection matrix and store it in VP
-        glm::mat4 VP = camera->getProjectionMatrix(this->windowSize) * camera->getViewMatrix();
+        //? The opaque commands get the occlusion slot of their mesh renderer (the slots are only touched on this thread)
+        //? and go to the occluded commands if their box was hidden the last time it was tested.
+        //? The boxes crossing the near plane are never tested since their clipped front faces would let them be hidden by their own object.
+        if (occlusion.isEnabled() && packet.perspective)
+        {
+            for (size_t index = 0; index < packet.candidates.size(); index++)
+            {
+                RenderCommand &command = packet.candidates[index];
+                float radius = packet.candidateSpheres.radius[index];
+                if (packet.candidateQueues[index] != RenderQueue::OPAQUE_COMMANDS || std::isinf(radius) ||
+                    glm::dot(packet.forward, command.center - packet.eye) - 1.05f * radius <= packet.near)
+                    continue;
+                command.occlusionSlot = occlusion.getSlot(candidateRenderers[index]);
+                if (!occlusion.isVisible(command.occlusionSlot))
+                    packet.candidateQueues[index] = RenderQueue::OCCLUDED_COMMANDS;
+            }
+        }
 
-        // DONE: (Req 9) Set the OpenGL viewport using viewportStart and viewportSize
-        //? Sets the viewport to cover the entire window.
-        glViewport(0, 0, this->windowSize.x, this->windowSize.y);
+        // The light positions & directions are computed once per frame in world space.
+        // The global lights are written first then the local lights (whose spheres of influence are assigned to the clusters).
+        packet.lightData.clear();
+        packet.lightSpheres.clear();
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (LightComponent *light : lightComponents)
+            {
+                float range = light->LightType == LightType::DIRECTIONAL ? INFINITY : computeLightRange(light->attenuation, light->diffuse, light->specular);
+                bool global = std::isinf(range);
+                if (global != (pass == 0) || range <= 0.0f)
+                    continue;
+                glm::mat4 lightToWorld = light->getOwner()->getLocalToWorldMatrix();
+                LightData data = {};
+                data.type = (float)light->LightType;
+                // we take the translation column of the local to world matrix to get the position
+                data.position = glm::vec3(lightToWorld[3]);
+                data.direction = light->LightType == LightType::POINT ? glm::vec3(0.0f) : glm::normalize(glm::vec3(lightToWorld * glm::vec4(light->direction, 0)));
+                data.diffuse = light->diffuse;
+                data.specular = light->specular;
+                data.attenuation = light->attenuation;
+                data.innerCone = light->cone_angles.x;
+                data.outerCone = light->cone_angles.y;
+                packet.lightData.push_back(data);
+                if (!global)
+                    packet.lightSpheres.push_back(glm::vec4(data.position, range));
+            }
+        }
+        packet.globalLightCount = (GLint)(packet.lightData.size() - packet.lightSpheres.size());
+        packet.valid = true;
+        return camera;
+    }
 
-        // DONE: (Req 9) Set the clear color to black and the clear depth to 1
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClearDepth(1.0);
+    void ForwardRenderer::preparePacket(RenderPacket &packet)
+    {
+        packet.opaqueCommands.clear();
+        packet.transparentCommands.clear();
+        packet.oitCommands.clear();
+        packet.occludedCommands.clear();
+        packet.visibleCommands = packet.culledCommands = 0;
+        if (!packet.valid)
+            return;
 
-        // DONE: (Req 9) Set the color mask to true and the depth mask to true (to ensure the glClear will affect the framebuffer)
-        glColorMask(true, true, true, true);
-        glDepthMask(true);
+        // The commands whose bounding spheres are outside the camera frustum are dropped before sorting
+        if (culling)
+        {
+            size_t visibleCount = cullSpheres(Frustum::fromViewProjection(packet.P * packet.V), packet.candidateSpheres, packet.visibility);
+            packet.visibleCommands = visibleCount;
+            packet.culledCommands = packet.candidates.size() - visibleCount;
+        }
+        else
+        {
+            packet.visibility.assign(packet.candidates.size(), 1);
+            packet.visibleCommands = packet.candidates.size();
+        }
+        for (size_t index = 0; index < packet.candidates.size(); index++)
+        {
+            if (!packet.visibility[index])
+                continue;
+            switch (packet.candidateQueues[index])
+            {
+            case RenderQueue::OPAQUE_COMMANDS:
+                packet.opaqueCommands.push_back(packet.candidates[index]);
+                break;
+            case RenderQueue::TRANSPARENT_COMMANDS:
+                packet.transparentCommands.push_back(packet.candidates[index]);
+                break;
+            case RenderQueue::OIT_COMMANDS:
+                packet.oitCommands.push_back(packet.candidates[index]);
+                break;
+            case RenderQueue::OCCLUDED_COMMANDS:
+                packet.occludedCommands.push_back(packet.candidates[index]);
+                break;
+            }
+        }
 
-        // If there is a postprocess material, bind the framebuffer
-        if (postprocessMaterial)
+        //? The depth of each command is its distance from the camera along the forward direction,
+        //? normalized such that the near plane is 0 and the far plane is 1 (then the sort keys quantize it)
+        float depthScale = 1.0f / std::max(packet.far - packet.near, 1e-6f);
+        float depthOffset = -(glm::dot(packet.forward, packet.eye) + packet.near) * depthScale;
+        for (auto *commands : {&packet.opaqueCommands, &packet.occludedCommands})
         {
-            // DONE: (Req 11) bind the framebuffer
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, postprocessFrameBuffer);
+            for (auto &command : *commands)
+            {
+                float depth = glm::dot(packet.forward, command.center) * depthScale + depthOffset;
+                command.sortKey = render_sort::opaqueKey(command.material->shader->getSortID(), command.material->getSortID(),
+                                                         command.mesh->getSortID() * MAX_MESH_LODS + command.lod, depth);
+            }
+        }
+        for (auto &command : packet.transparentCommands)
+        {
+            //DONE: (Req 9) Finish this function
+            //? The transparent commands are drawn from the farthest to the closest (the key inverts the depth)
+            float depth = glm::dot(packet.forward, command.center) * depthScale + depthOffset;
+            command.sortKey = render_sort::transparentKey(command.material->shader->getSortID(), command.material->getSortID(),
+                                                          command.mesh->getSortID() * MAX_MESH_LODS + command.lod, depth);
         }
+        sortCommands(packet.opaqueCommands);
+        sortCommands(packet.occludedCommands);
+        sortCommands(packet.transparentCommands);
 
-        // DONE: (Req 9) Clear the color and depth buffers
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // The local lights are assigned to the clusters of the camera
+        packet.lightClusters.build(packet.lightSpheres, packet.V, packet.P, packet.perspective, packet.near, packet.far, maxLightIndices);
+    }
 
-        // DONE: (Req 9) Draw all the opaque commands
-        //  Don't forget to set the "transform" uniform to be equal the model-view-projection matrix for each render command
-        for (auto command : opaqueCommands)
+    CameraComponent *ForwardRenderer::collectCommands(World *world)
+    {
+        // The worker may still be preparing a packet (which uses the same sorting buffers)
+        packetWorker.wait();
+        RenderPacket &packet = packets[nextPacket];
+        CameraComponent *camera = extractPacket(world, packet);
+        preparePacket(packet);
+        lastPacket = &packet;
+        return camera;
+    }
+
+    void ForwardRenderer::sortCommands(std::vector<RenderCommand> &commands)
+    {
+        // The keys are sorted with their indices (instead of sorting the commands directly) so the radix sort moves 16 bytes per entry
+        // then the commands are moved once into their final order
+        sortEntries.resize(commands.size());
+        for (size_t i = 0; i < commands.size(); i++)
+            sortEntries[i] = {commands[i].sortKey, (uint32_t)i};
+        render_sort::radixSort(sortEntries, sortScratch);
+        render_sort::applyOrder(sortEntries, commands, commandScratch);
+    }
+
+    void ForwardRenderer::updateFrameBuffers(const RenderPacket &packet)
+    {
+        const LightClusters &lightClusters = packet.lightClusters;
+        lightDataBuffer->update(packet.lightData.data(), packet.lightData.size() * sizeof(LightData));
+        lightClusterBuffer->update(lightClusters.getRanges().data(), lightClusters.getRanges().size() * sizeof(glm::uvec2));
+        lightIndexBuffer->update(lightClusters.getIndices().data(), lightClusters.getIndices().size() * sizeof(uint16_t));
+        RenderStats::current().lights += packet.lightData.size();
+        RenderStats::current().clusterLights += lightClusters.getIndices().size();
+
+        FrameData frameData;
+        frameData.VP = packet.P * packet.V;
+        frameData.eye = glm::vec4(packet.eye, 1.0f);
+        frameData.skyTop = glm::vec4(0.0f, 1.0f, 0.5f, 1.0f);
+        frameData.skyMiddle = glm::vec4(0.3f, 0.3f, 0.3f, 1.0f);
+        frameData.skyBottom = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
+        const glm::mat4 &V = packet.V;
+        frameData.viewDepth = -glm::vec4(V[0][2], V[1][2], V[2][2], V[3][2]);
+        glm::ivec3 gridSize = lightClusters.getGridSize();
+        frameData.clusterScale = glm::vec4(glm::vec2(gridSize) / glm::vec2(packet.renderSize), lightClusters.getDepthSliceParameters());
+        frameData.clusterCount = glm::ivec4(gridSize.x, gridSize.y, packet.perspective ? gridSize.z : 1, packet.globalLightCount);
+        frameDataBuffer->update(&frameData, sizeof(frameData));
+
+        frameDataBuffer->bind(uniform_blocks::FRAME_DATA);
+        lightDataBuffer->bind(light_units::DATA);
+        lightClusterBuffer->bind(light_units::CLUSTERS);
+        lightIndexBuffer->bind(light_units::INDICES);
+    }
+
+    void ForwardRenderer::setupLitMaterial(LightMaterial *material, const glm::mat4 &localToWorld, uint32_t variant)
+    {
+        material->setup(variant);
+        // send the model matrix and its inverse transpose (for the normals) to the shader
+        ShaderProgram *shader = material->shader->getVariant(variant);
+        setLightUniforms(shader);
+        shader->set(uniforms::M, localToWorld);
+        shader->set(uniforms::M_IT, glm::transpose(glm::inverse(localToWorld)));
+    }
+
+    bool ForwardRenderer::usesDepthPrepass(const Material *material) const
+    {
+        // Only the opaque lit materials that write the depth pay for the shading of the hidden fragments
+        if (!depthPrepass || !dynamic_cast<const LightMaterial *>(material))
+            return false;
+        const PipelineState &state = material->pipelineState;
+        if (!state.depthTesting.enabled || !state.depthMask || state.blending.enabled)
+            return false;
+        return material->shader->getVariant(shader_variant::DEPTH_ONLY) != nullptr;
+    }
+
+    // Makes the shading pass of a prepassed command only draw the fragments that won the depth prepass
+    static void setupPrepassedDepth()
+    {
+        GLState::depthFunc(GL_EQUAL);
+        GLState::depthMask(false);
+    }
+
+    void ForwardRenderer::drawDepthPrepass(const std::vector<RenderCommand> &commands)
+    {
+        // The same grouping as "drawCommands" (the commands are sorted so the commands sharing a mesh & a material are next to each other)
+        for (size_t first = 0; first < commands.size();)
         {
-            //* Responsible for rendering all the opaque objects in the scene
+            const RenderCommand &command = commands[first];
+            size_t last = first + 1;
+            while (last < commands.size() && commands[last].mesh == command.mesh &&
+                   commands[last].material == command.material && commands[last].lod == command.lod)
+                last++;
+            GLsizei count = (GLsizei)(last - first);
+            if (!usesDepthPrepass(command.material))
+            {
+                first = last;
+                continue;
+            }
 
-            //? 1- calculates the model-view-projection matrix= multiplying the camera view-projection matrix VP by the local-to-world matrix of the object.
-            //? 2- sets up the material of the object by calling setup func. that sets the material properties
-            //? 3- binding to crossponding shader ("transform")
-            //? 4- draw mesh  to render object
-            // check if the command  is a lighted material or not
+            ShaderProgram *shader = nullptr;
+            uint32_t variant = shader_variant::DEPTH_ONLY | shader_variant::INSTANCED;
+            if (instancing && count >= minInstances)
+            {
+                variant = getMeshVariant(command.material, command.mesh, variant);
+                shader = command.material->shader->getVariant(variant);
+            }
+            bool instanced = shader != nullptr;
+            if (!instanced)
+            {
+                variant = getMeshVariant(command.material, command.mesh, shader_variant::DEPTH_ONLY);
+                shader = command.material->shader->getVariant(variant);
+            }
 
-            if (auto material = dynamic_cast<LightMaterial *>(command.material))
+            // The material state is kept (e.g. its face culling) so the depth matches the shading pass but the colors are not written
+            command.material->pipelineState.setup();
+            GLState::colorMask({false, false, false, false});
+            GLState::depthMask(true);
+            shader->use();
+            setMeshUniforms(shader, command.mesh);
+            if (instanced)
             {
-                if (material != nullptr)
-                {
-                    material->setup();
-                    // vertex shader
-                    // send the camera position to the shader
-                    material->shader->set("eye", eyeTransparency);
-                    // send the view projection matrix to the shader
-                    material->shader->set("VP", VP);
-                    // send the model matrix to the shader
-                    material->shader->set("M", command.localToWorld);
-                    // send the model view matrix to the shader
-                    material->shader->set("M_IT", glm::transpose(glm::inverse(command.localToWorld)));
-                    // fragment shader
-                    // sky light color data
-                    // send the sky light color data to the shader
-                    material->shader->set("Sky.top", glm::vec3(0.0f, 1.0f, 0.5f));
-                    material->shader->set("Sky.middle", glm::vec3(0.3f, 0.3f, 0.3f));
-                    material->shader->set("Sky.bottom", glm::vec3(0.1f, 0.1f, 0.1f));
-                    //  send the light count
-                    material->shader->set("light_count", (GLint)lightComponents.size());
-                    // loop over the light components and send the light data to the shader
-                    for (auto i = 0; i < (int)lightComponents.size(); i++)
-                    {
-                        material->shader->set("lights[" + std::to_string(i) + "].type", (GLint)lightComponents[i]->LightType);
-                        // in case of directional light we need to send the direction of the light only
-                        if (lightComponents[i]->LightType == LightType::DIRECTIONAL)
-                        {
-                            // calculate the light direction in world space from entity component
-                            glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->direction, 0));
-                            material->shader->set("lights[" + std::to_string(i) + "].direction", directional_direction);
-                        }
-                        // in case of point light we need to send the position of the light only
-                        else if (lightComponents[i]->LightType == LightType::POINT)
-                        {
-                            glm::vec3 position = glm::vec3(lightComponents[i]->getOwner()->getLocalToWorldMatrix()[3]);
-                            material->shader->set("lights[" + std::to_string(i) + "].position", position);
-                        }
-                        // in case of spot light we need to send the position and direction of the light
-                        else if (lightComponents[i]->LightType == LightType::SPOT)
-                        {
-                            // glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->getOwner()->localTransform.rotation ,0));
-                            // glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->getOwner()->localTransform.rotation ,0));
-                            glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->direction, 0));
-                            // cout the direction of the light
-                            // std::cout << "directional_direction: " << directional_direction.x << " " << directional_direction.y << " " << directional_direction.z << std::endl;
-                            // we multiply local to world matrix by (0,0,0,1) to get the vec3 and drop the w component
-                            glm::vec3 position = glm::vec3(lightComponents[i]->getOwner()->getLocalToWorldMatrix()[3]);
-                            material->shader->set("lights[" + std::to_string(i) + "].position", position);
-                            material->shader->set("lights[" + std::to_string(i) + "].direction", directional_direction);
-                            material->shader->set("lights[" + std::to_string(i) + "].cone_angles", lightComponents[i]->cone_angles);
-                        }
-                        // material->shader->set("lights[" + std::to_string(i) + "].color", lightComponents[i]->color);
-                        material->shader->set("lights[" + std::to_string(i) + "].attenuation", lightComponents[i]->attenuation);
-                        material->shader->set("lights[" + std::to_string(i) + "].diffuse", lightComponents[i]->diffuse);
-                        material->shader->set("lights[" + std::to_string(i) + "].specular", lightComponents[i]->specular);
-                    }
-                }
+                // Only the model matrices are needed for the depth
+                instanceData.resize(count);
+                for (GLsizei index = 0; index < count; index++)
+                    instanceData[index].M = commands[first + index].localToWorld;
+                GLintptr offset = instanceBuffer->append(instanceData.data(), count);
+                command.mesh->drawInstanced(count, *instanceBuffer, offset, command.lod);
             }
             else
             {
-                glm::mat4 modelViewProjection = VP * command.localToWorld;
-                command.material->setup();
-                command.material->shader->set("transform", modelViewProjection);
+                for (size_t index = first; index < last; index++)
+                {
+                    shader->set(uniforms::M, commands[index].localToWorld);
+                    commands[index].mesh->draw(commands[index].lod);
+                }
             }
+            first = last;
+        }
+    }
 
-            command.mesh->draw();
+    void ForwardRenderer::drawOcclusionTests(const RenderPacket &packet, const glm::mat4 &VP)
+    {
+        // The boxes of all the tested commands are drawn first (against the depth of the visible opaque commands).
+        // The boxes of the visible commands are not hidden by their own object (they are around it) so they only fail if something else hides them.
+        // The boxes of the hidden commands are always tested again since their draws below are conditioned on a test of this frame.
+        occlusion.beginProxies();
+        for (const RenderCommand &command : packet.opaqueCommands)
+            if (command.occlusionSlot != OcclusionCulling::NO_SLOT)
+                occlusion.drawProxy(command.occlusionSlot, VP * command.localToWorld, command.mesh->getBounds());
+        for (const RenderCommand &command : packet.occludedCommands)
+            occlusion.drawProxy(command.occlusionSlot, VP * command.localToWorld, command.mesh->getBounds(), true);
+
+        // Then the commands that were hidden are drawn one by one, each one only if its box passed the test of this frame
+        RenderStats::current().occludedCommands += packet.occludedCommands.size();
+        for (const RenderCommand &command : packet.occludedCommands)
+        {
+            bool conditional = occlusion.beginConditionalRender(command.occlusionSlot);
+            drawCommand(command, VP, false, shader_variant::NONE);
+            if (conditional)
+                occlusion.endConditionalRender();
         }
+    }
 
-        // If there is a sky material, draw the sky
-        if (this->skyMaterial)
+    // Makes a transparent command accumulate into the OIT targets: the weighted colors (rgb) & the weights are added
+    // while the alpha of the first target (the revealage) is multiplied by (1 - alpha). The depth is tested but not written.
+    static void setupOITBlending()
+    {
+        GLState::setEnabled(GL_BLEND, true);
+        GLState::blendEquation(GL_FUNC_ADD);
+        GLState::blendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::depthMask(false);
+    }
+
+    void ForwardRenderer::accumulateOIT(const std::vector<RenderCommand> &commands, const glm::mat4 &VP)
+    {
+        // The colors & weights start at 0 and the revealage at 1 (fully revealed)
+        static const GLfloat clearAccum[] = {0.0f, 0.0f, 0.0f, 1.0f}, clearWeight[] = {0.0f, 0.0f, 0.0f, 0.0f};
+        GLState::colorMask({true, true, true, true});
+        glClearBufferfv(GL_COLOR, 0, clearAccum);
+        glClearBufferfv(GL_COLOR, 1, clearWeight);
+        drawCommands(commands, VP, false, shader_variant::OIT);
+    }
+
+    void ForwardRenderer::compositeOIT(Texture2D *accum, Texture2D *weights)
+    {
+        // Resolve the targets over the scene with a fullscreen triangle
+        oitCompositeState.setup();
+        oitCompositeShader->use();
+        GLState::activeTexture(GL_TEXTURE0);
+        accum->bind();
+        GLState::bindSampler(0, 0);
+        GLState::activeTexture(GL_TEXTURE1);
+        weights->bind();
+        GLState::bindSampler(1, 0);
+        oitCompositeShader->set(uniforms::accum, 0);
+        oitCompositeShader->set(uniforms::weights, 1);
+        GLState::bindVertexArray(postProcessVertexArray);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        RenderStats::current().drawCalls++;
+        RenderStats::current().triangles++;
+    }
+
+    void ForwardRenderer::drawCommand(const RenderCommand &command, const glm::mat4 &VP, bool prepassed, uint32_t passVariant)
+    {
+        //? 1- calculates the model-view-projection matrix= multiplying the camera view-projection matrix VP by the local-to-world matrix of the object.
+        //? 2- sets up the material of the object by calling setup func. that sets the material properties
+        //? 3- binding to crossponding shader ("transform")
+        //? 4- draw mesh  to render object
+        // check if the command  is a lighted material or not
+        uint32_t variant = getMeshVariant(command.material, command.mesh, passVariant);
+        ShaderProgram *shader = command.material->shader->getVariant(variant);
+        if (auto material = dynamic_cast<LightMaterial *>(command.material))
         {
-            // DONE: (Req 10) setup the sky material
-            this->skyMaterial->setup();
-
-            // DONE: (Req 10) Get the camera position
-            glm::vec3 cameraPosition = M * glm::vec4(0.0, 0.0, 0.0, 1.0);
-
-            // DONE: (Req 10) Create a model matrix for the sy such that it always follows the camera (sky sphere center = camera position)
-            glm::mat4 identity = glm::mat4(1.0f);
-            glm::mat4 skyModelMatrix = glm::translate(identity, cameraPosition);
-
-            // DONE: (Req 10) We want the sky to be drawn behind everything (in NDC space, z=1)
-            //  We can acheive the is by multiplying by an extra matrix after the projection but what values should we put in it?
-            glm::mat4 alwaysBehindTransform = glm::mat4(
-                1.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, 1.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 1.0f, 1.0f);
-            // DONE: (Req 10) set the "transform" uniform
-            glm::mat4 transform = alwaysBehindTransform * VP * skyModelMatrix;
-            skyMaterial->shader->set("transform", transform);
-            // DONE: (Req 10) draw the sky sphere
-            this->skySphere->draw();
+            setupLitMaterial(material, command.localToWorld, variant);
         }
-        // DONE: (Req 9) Draw all the transparent commands
-        //  Don't forget to set the "transform" uniform to be equal the model-view-projection matrix for each render command
-        for (auto command : transparentCommands)
+        else
+        {
+            glm::mat4 modelViewProjection = VP * command.localToWorld;
+            command.material->setup(variant);
+            shader->set(uniforms::transform, modelViewProjection);
+        }
+        if (prepassed && usesDepthPrepass(command.material))
+            setupPrepassedDepth();
+        if (passVariant & shader_variant::OIT)
+            setupOITBlending();
+        setMeshUniforms(shader, command.mesh);
+        command.mesh->draw(command.lod);
+    }
+
+    void ForwardRenderer::drawCommands(const std::vector<RenderCommand> &commands, const glm::mat4 &VP, bool prepassed, uint32_t passVariant)
+    {
+        // The commands are sorted so the commands sharing a mesh & a material are next to each other
+        for (size_t first = 0; first < commands.size();)
         {
-            //* Responsible for rendering all the transparent objects in the scene
-
-            //? 1- calculates the model-view-projection matrix= multiplying the camera view-projection matrix VP by the local-to-world matrix of the object.
-            //? 2- sets up the material of the object by calling setup func. that sets the material properties
-            //? 3- binding to crossponding shader ("transform")
-            //? 4- draw mesh  to render object
-
-            // glm::mat4 modelViewProjection = VP * command.localToWorld;
-            // command.material->setup();
-            // command.material->shader->set("transform", modelViewProjection);
-            // command.mesh->draw();
-            if (auto material = dynamic_cast<LightMaterial *>(command.material))
+            const RenderCommand &command = commands[first];
+            size_t last = first + 1;
+            while (last < commands.size() && commands[last].mesh == command.mesh &&
+                   commands[last].material == command.material && commands[last].lod == command.lod)
+                last++;
+            GLsizei count = (GLsizei)(last - first);
+
+            // Small batches (and shaders without an instanced variant) are drawn one by one
+            ShaderProgram *instancedShader = nullptr;
+            uint32_t variant = shader_variant::INSTANCED | passVariant;
+            if (instancing && count >= minInstances)
             {
-                if (material != nullptr)
-                {
-                    material->setup();
-                    // vertex shader
-                    // send the camera position to the shader
-                    material->shader->set("eye", eyeTransparency);
-                    // send the view projection matrix to the shader
-                    material->shader->set("VP", VP);
-                    // send the model matrix to the shader
-                    material->shader->set("M", command.localToWorld);
-                    // send the model view matrix to the shader
-                    material->shader->set("M_IT", glm::transpose(glm::inverse(command.localToWorld)));
-                    // fragment shader
-                    // sky light color data
-                    // send the sky light color data to the shader
-                    material->shader->set("Sky.top", glm::vec3(0.0f, 1.0f, 0.5f));
-                    material->shader->set("Sky.middle", glm::vec3(0.3f, 0.3f, 0.3f));
-                    material->shader->set("Sky.bottom", glm::vec3(0.1f, 0.1f, 0.1f));
-                    //  send the light count
-                    material->shader->set("light_count", (GLint)lightComponents.size());
-                    // loop over the light components and send the light data to the shader
-                    for (auto i = 0; i < (int)lightComponents.size(); i++)
-                    {
-                        material->shader->set("lights[" + std::to_string(i) + "].type", (GLint)lightComponents[i]->LightType);
-                        // in case of directional light we need to send the direction of the light only
-                        if (lightComponents[i]->LightType == LightType::DIRECTIONAL)
-                        {
-                            // calculate the light direction in world space from entity component
-                            // glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->getOwner()->localTransform.rotation ,0));
-                            glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->direction, 0));
-                            material->shader->set("lights[" + std::to_string(i) + "].direction", directional_direction);
-                        }
-                        // in case of point light we need to send the position of the light only
-                        else if (lightComponents[i]->LightType == LightType::POINT)
-                        {
-                            glm::vec3 position = glm::vec3(lightComponents[i]->getOwner()->getLocalToWorldMatrix()[3]);
-                            material->shader->set("lights[" + std::to_string(i) + "].position", position);
-                        }
-                        // in case of spot light we need to send the position and direction of the light
-                        else if (lightComponents[i]->LightType == LightType::SPOT)
-                        {
-                            // glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->getOwner()->localTransform.rotation ,0));
-                            glm::vec3 directional_direction = glm::normalize(lightComponents[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(lightComponents[i]->direction, 0));
-                            // cout the direction of the light
-                            // std::cout << "directional_direction: " << directional_direction.x << " " << directional_direction.y << " " << directional_direction.z << std::endl;
-                            // we multiply local to world matrix by (0,0,0,1) to get the vec3 and drop the w component
-                            glm::vec3 position = glm::vec3(lightComponents[i]->getOwner()->getLocalToWorldMatrix()[3]);
-                            material->shader->set("lights[" + std::to_string(i) + "].position", position);
-                            material->shader->set("lights[" + std::to_string(i) + "].direction", directional_direction);
-                            material->shader->set("lights[" + std::to_string(i) + "].cone_angles", lightComponents[i]->cone_angles);
-                        }
-                        // material->shader->set("lights[" + std::to_string(i) + "].color", lightComponents[i]->color);
-                        material->shader->set("lights[" + std::to_string(i) + "].attenuation", lightComponents[i]->attenuation);
-                        material->shader->set("lights[" + std::to_string(i) + "].diffuse", lightComponents[i]->diffuse);
-                        material->shader->set("lights[" + std::to_string(i) + "].specular", lightComponents[i]->specular);
-                    }
-                }
+                variant = getMeshVariant(command.material, command.mesh, variant);
+                instancedShader = command.material->shader->getVariant(variant);
             }
-            else
+            if (!instancedShader)
             {
-                glm::mat4 modelViewProjection = VP * command.localToWorld;
-                command.material->setup();
-                command.material->shader->set("transform", modelViewProjection);
+                for (size_t index = first; index < last; index++)
+                    drawCommand(commands[index], VP, prepassed, passVariant);
+                first = last;
+                continue;
             }
 
-            command.mesh->draw();
+            // The lit shaders need the inverse transpose of each model matrix for the normals
+            auto material = dynamic_cast<LightMaterial *>(command.material);
+            instanceData.resize(count);
+            for (GLsizei index = 0; index < count; index++)
+            {
+                instanceData[index].M = commands[first + index].localToWorld;
+                if (material)
+                    instanceData[index].M_IT = glm::transpose(glm::inverse(instanceData[index].M));
+            }
+            GLintptr offset = instanceBuffer->append(instanceData.data(), count);
+
+            command.material->setup(variant);
+            if (prepassed && usesDepthPrepass(command.material))
+                setupPrepassedDepth();
+            if (passVariant & shader_variant::OIT)
+                setupOITBlending();
+            // The unlit shaders get the view-projection matrix in "transform" since the model matrices come from the instances
+            if (!material)
+                instancedShader->set(uniforms::transform, VP);
+            else
+                setLightUniforms(instancedShader);
+            setMeshUniforms(instancedShader, command.mesh);
+            command.mesh->drawInstanced(count, *instanceBuffer, offset, command.lod);
+            first = last;
         }
+    }
 
-        // If there is a postprocess material, apply postprocessing
-        if (postprocessMaterial)
+    void ForwardRenderer::drawSky(const glm::vec3 &eye, const glm::mat4 &VP)
+    {
+        // DONE: (Req 10) setup the sky material
+        this->skyMaterial->setup();
+
+        // DONE: (Req 10) Get the camera position
+        glm::vec3 cameraPosition = eye;
+
+        // DONE: (Req 10) Create a model matrix for the sy such that it always follows the camera (sky sphere center = camera position)
+        glm::mat4 identity = glm::mat4(1.0f);
+        glm::mat4 skyModelMatrix = glm::translate(identity, cameraPosition);
+
+        // DONE: (Req 10) We want the sky to be drawn behind everything (in NDC space, z=1)
+        //  We can acheive the is by multiplying by an extra matrix after the projection but what values should we put in it?
+        glm::mat4 alwaysBehindTransform = glm::mat4(
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 1.0f);
+        // DONE: (Req 10) set the "transform" uniform
+        glm::mat4 transform = alwaysBehindTransform * VP * skyModelMatrix;
+        skyMaterial->shader->set(uniforms::transform, transform);
+        // DONE: (Req 10) draw the sky sphere
+        this->skySphere->draw();
+    }
+
+    void ForwardRenderer::render(World *world)
+    {
+        if (!pipelining)
         {
-            // DONE: (Req 11) Return to the default framebuffer
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-
-            ShaderProgram *postprocessShader = new ShaderProgram();
-            // attach the vertex shader
-            postprocessShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
-
-            // attach the fragment shader based on the effect type (fish eye or blur or power up or radial blur or vignette)
-            if (effectOne)
-                postprocessShader->attach("assets/shaders/postprocess/chromatic-aberration.frag", GL_FRAGMENT_SHADER);
-            else if (effectTwo)
-                postprocessShader->attach("assets/shaders/postprocess/radial-blur.frag", GL_FRAGMENT_SHADER);
-            else
-                postprocessShader->attach("assets/shaders/postprocess/vignette.frag", GL_FRAGMENT_SHADER);
+            // Collect and sort the commands, if there is no camera, we return (we cannot render without a camera)
+            RenderPacket &packet = packets[0];
+            if (extractPacket(world, packet) == nullptr)
+                return;
+            preparePacket(packet);
+            lastPacket = &packet;
+            submitPacket(packet);
+            return;
+        }
+
+        // The packet of this frame is extracted while the worker may still be preparing the packet of the previous frame (in the other slot).
+        // Once the worker is done, it prepares this packet while the previous one is drawn.
+        RenderPacket &packet = packets[nextPacket];
+        extractPacket(world, packet);
+        packetWorker.wait();
+        packetWorker.start([this, &packet]()
+                           { preparePacket(packet); });
+        nextPacket = 1 - nextPacket;
+        const RenderPacket &previous = packets[nextPacket];
+        lastPacket = &previous;
+        if (previous.valid)
+            submitPacket(previous);
+    }
 
-            // link the shader program
-            postprocessShader->link();
+    void ForwardRenderer::submitPacket(const RenderPacket &packet)
+    {
+        RenderStats::current().visibleCommands += packet.visibleCommands;
+        RenderStats::current().culledCommands += packet.culledCommands;
+        glm::ivec2 renderSize = packet.renderSize;
+        RenderStats::current().scenePixels += (uint64_t)renderSize.x * renderSize.y;
 
-            // create a postprocess material for the postprocess shader
-            postprocessMaterial->shader = postprocessShader;
+        // DONE: (Req 9) Get the camera ViewProjection matrix and store it in VP
+        glm::mat4 VP = packet.P * packet.V;
+
+        // Send the camera, the sky and the lights to the lit shaders once for the whole frame
+        updateFrameBuffers(packet);
+        // The results of the occlusion queries of the previous frames are read if they are done (they are used by the next extracted packet)
+        if (occlusion.isEnabled())
+            occlusion.collectResults();
+
+        // The instance data of all the instanced batches of this frame is appended to the same buffer
+        // (at most one instance per command and one more per opaque command for the depth prepass)
+        size_t maxInstances = packet.getCommandCount() + (depthPrepass ? packet.opaqueCommands.size() : 0);
+        instanceBuffer->begin((GLsizeiptr)(maxInstances * sizeof(InstanceData)));
+
+        // The passes of the frame are declared in the render graph which allocates their textures & framebuffers (see RenderGraph).
+        // With postprocessing, the scene is drawn to transient textures which the postprocess pass reads to draw to the window.
+        graph.reset();
+        RenderGraph::ResourceID color = RenderGraph::BACKBUFFER, depth = RenderGraph::BACKBUFFER;
+        if (postprocess)
+        {
+            color = graph.createTexture("scene color", windowSize, GL_RGBA8);
+            depth = graph.createTexture("scene depth", windowSize, GL_DEPTH_COMPONENT24);
+        }
+        // Most passes draw to the color & the depth of the scene
+        auto addScenePass = [&](const std::string &name, std::function<void(const RenderGraph &)> execute)
+        {
+            RenderGraph::PassID pass = graph.addPass(name, std::move(execute));
+            graph.write(pass, color);
+            graph.write(pass, depth);
+            return pass;
+        };
+
+        addScenePass("clear", [this, renderSize](const RenderGraph &)
+                     {
+            // DONE: (Req 9) Set the OpenGL viewport using viewportStart and viewportSize
+            //? Sets the viewport to cover the entire window.
+            glViewport(0, 0, renderSize.x, renderSize.y);
+
+            // DONE: (Req 9) Set the clear color to black and the clear depth to 1
+            GLState::setEnabled(GL_DEPTH_TEST, true);
+            GLState::depthFunc(GL_LESS);
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClearDepth(1.0);
+
+            // DONE: (Req 9) Set the color mask to true and the depth mask to true (to ensure the glClear will affect the framebuffer)
+            GLState::colorMask({true, true, true, true});
+            GLState::depthMask(true);
+
+            // DONE: (Req 9) Clear the color and depth buffers
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); });
+
+        // The depth of the opaque lit commands is drawn first (if the depth prepass is enabled)
+        if (depthPrepass)
+            addScenePass("depth prepass", [this, &packet](const RenderGraph &)
+                         { drawDepthPrepass(packet.opaqueCommands); });
 
-            // DONE: (Req 11) Setup the postprocess material and draw the fullscreen triangle
-            glBindVertexArray(postProcessVertexArray);
-            postprocessMaterial->setup();
-            glDrawArrays(GL_TRIANGLES, 0, 3);
+        // DONE: (Req 9) Draw all the opaque commands
+        //  Don't forget to set the "transform" uniform to be equal the model-view-projection matrix for each render command
+        addScenePass("opaque", [this, &packet, VP](const RenderGraph &)
+                     { drawCommands(packet.opaqueCommands, VP, depthPrepass); });
+
+        // The boxes of the opaque commands are tested and the commands that were hidden are drawn if their boxes are not hidden anymore
+        if (occlusion.isEnabled())
+            addScenePass("occlusion", [this, &packet, VP](const RenderGraph &)
+                         { drawOcclusionTests(packet, VP); });
+
+        // If there is a sky material, draw the sky
+        if (this->skyMaterial)
+            addScenePass("sky", [this, &packet, VP](const RenderGraph &)
+                         { drawSky(packet.eye, VP); });
+
+        // The OIT commands need no order so they are drawn before the sorted transparent commands.
+        // They accumulate into their own transient textures (testing the depth of the scene without writing it) which are then blended over the scene.
+        if (!packet.oitCommands.empty())
+        {
+            RenderGraph::ResourceID accum = graph.createTexture("oit accum", windowSize, GL_RGBA16F);
+            RenderGraph::ResourceID weights = graph.createTexture("oit weights", windowSize, GL_R16F);
+            RenderGraph::PassID accumulate = graph.addPass("transparent (oit)", [this, &packet, VP](const RenderGraph &)
+                                                           { accumulateOIT(packet.oitCommands, VP); });
+            graph.write(accumulate, accum);
+            graph.write(accumulate, weights);
+            graph.write(accumulate, depth);
+            RenderGraph::PassID composite = graph.addPass("oit composite", [this, accum, weights](const RenderGraph &graph)
+                                                          { compositeOIT(graph.getTexture(accum), graph.getTexture(weights)); });
+            graph.read(composite, accum);
+            graph.read(composite, weights);
+            graph.write(composite, color);
+        }
+
+        // DONE: (Req 9) Draw all the transparent commands
+        //  Don't forget to set the "transform" uniform to be equal the model-view-projection matrix for each render command
+        //? The instanced batches only group consecutive commands so the back-to-front order is kept
+        addScenePass("transparent", [this, &packet, VP](const RenderGraph &)
+                     { drawCommands(packet.transparentCommands, VP); });
+
+        // If there is a postprocess effect, apply postprocessing (using the effect selected by "setPostprocessEffect")
+        if (postprocess)
+        {
+            // DONE: (Req 11) Return to the default framebuffer (the last pass of the effect draws to it)
+            RenderGraph::PassID pass = graph.addPass("postprocess", [this, color, renderSize](const RenderGraph &graph)
+                                                     {
+                const RenderTarget *scene = graph.getTarget(color);
+                postprocess->render(scene->framebuffer, scene->texture, renderSize, this->windowSize, postProcessVertexArray); });
+            graph.read(pass, color);
+            graph.write(pass, RenderGraph::BACKBUFFER);
         }
+
+        graph.compile();
+        // The dynamic resolution measures all the passes of the frame (the postprocessing included) against its target frame time
+        dynamicResolution.begin();
+        graph.execute(&passTimers);
+        dynamicResolution.end();
+
+        // The times of the passes of the previous frames are collected once their queries are done
+        passTimers.endFrame();
+        // The transient targets that are no longer used (e.g. those of the previous render size) are deleted
+        targetPool.trim();
     }
 
 }
\ No newline at end of file
@@ -5,10 +5,24 @@
 #include "../components/light.hpp"
 #include "../components/mesh-renderer.hpp"
 #include "../asset-loader.hpp"
+#include "../shader/uniform-buffer.hpp"
+#include "../mesh/instance-buffer.hpp"
+#include "render-sort.hpp"
+#include "frustum-culling.hpp"
+#include "light-clusters.hpp"
+#include "postprocess-chain.hpp"
+#include "dynamic-resolution.hpp"
+#include "occlusion-culling.hpp"
+#include "render-graph.hpp"
+#include "../texture/texture-buffer.hpp"
+#include "../gpu-pass-timers.hpp"
+#include "../frame-worker.hpp"
 
 #include <glad/gl.h>
 #include <vector>
 #include <algorithm>
+#include <string>
+#include <unordered_map>
 
 namespace our
 {
@@ -22,8 +36,93 @@ namespace our
         glm::vec3 center;
         Mesh *mesh;
         Material *material;
+        // The level of detail of the mesh to draw (see MeshLOD)
+        int lod;
+        // The occlusion query slot of the command (see OcclusionCulling) or OcclusionCulling::NO_SLOT if it is never tested
+        uint32_t occlusionSlot;
+        // The draw order of the command (see "render-sort.hpp"). It is computed by "collectCommands" once the camera is known.
+        uint64_t sortKey;
     };
 
+    // The content of the "FrameData" uniform block (std140 layout) which is shared by all the lit draws of a frame
+    struct FrameData
+    {
+        glm::mat4 VP;
+        glm::vec4 eye; // xyz: the camera position
+        glm::vec4 skyTop, skyMiddle, skyBottom;
+        glm::vec4 viewDepth;     // The view depth of a world position p is dot(viewDepth, vec4(p, 1)) (the negated 3rd row of the view matrix)
+        glm::vec4 clusterScale;  // xy: the number of cluster tiles per pixel, zw: the depth slice scale & bias (see LightClusters)
+        glm::ivec4 clusterCount; // xyz: the size of the cluster grid, w: the number of global lights (at the start of the light data)
+    };
+    static_assert(sizeof(FrameData) == 176, "FrameData must match the std140 layout of the block");
+
+    // A light as stored in the light data buffer texture (5 RGBA32F texels per light, see "fetch_light" in "assets/shaders/lighted.frag")
+    // where the position & direction are already in world space
+    struct LightData
+    {
+        glm::vec3 position;
+        float type;
+        glm::vec3 direction;
+        float padding0;
+        glm::vec3 diffuse;
+        float innerCone;
+        glm::vec3 specular;
+        float outerCone;
+        glm::vec3 attenuation;
+        float padding1;
+    };
+    static_assert(sizeof(LightData) == 5 * sizeof(glm::vec4), "LightData must be 5 RGBA32F texels");
+
+    // The list a command goes to: the opaque commands, the sorted transparent commands, the order-independent transparent commands
+    // or the opaque commands whose last occlusion query found them hidden (the names avoid OPAQUE & TRANSPARENT which are macros on Windows)
+    enum class RenderQueue : uint8_t
+    {
+        OPAQUE_COMMANDS,
+        TRANSPARENT_COMMANDS,
+        OIT_COMMANDS,
+        OCCLUDED_COMMANDS
+    };
+
+    // Everything needed to draw a frame. It is filled from the world on the main thread (see "extractPacket"),
+    // then culled, sorted & clustered by "preparePacket" which touches neither the world nor OpenGL (so it can run on a worker thread)
+    // and finally drawn by "submitPacket". Nothing in the packet points to the entities so the world can change while it is prepared.
+    struct RenderPacket
+    {
+        // False if the world had no camera
+        bool valid = false;
+        // The camera
+        glm::mat4 V, P;
+        glm::vec3 eye, forward;
+        bool perspective;
+        float near, far;
+        // The size of the scene (see DynamicResolution)
+        glm::ivec2 renderSize;
+        // The commands of all the mesh renderers (with their LODs already picked), their world space bounding spheres and their queues
+        std::vector<RenderCommand> candidates;
+        BoundingSpheres candidateSpheres;
+        std::vector<RenderQueue> candidateQueues;
+        // The lights in world space: the global lights first then the local lights whose spheres of influence are in "lightSpheres"
+        std::vector<LightData> lightData;
+        std::vector<glm::vec4> lightSpheres;
+        GLint globalLightCount = 0;
+
+        // Filled by "preparePacket": the visible commands of each queue in their draw order and the light lists of the clusters
+        std::vector<uint8_t> visibility;
+        std::vector<RenderCommand> opaqueCommands, transparentCommands, oitCommands, occludedCommands;
+        LightClusters lightClusters;
+        uint64_t visibleCommands = 0, culledCommands = 0;
+
+        size_t getCommandCount() const { return opaqueCommands.size() + transparentCommands.size() + oitCommands.size() + occludedCommands.size(); }
+    };
+
+    // The texture units of the light buffer textures read by the lit shaders (the material textures use the first units)
+    namespace light_units
+    {
+        constexpr GLint DATA = 8;     // "light_data": the lights (see LightData)
+        constexpr GLint CLUSTERS = 9; // "light_clusters": the (offset, count) of the light list of each cluster
+        constexpr GLint INDICES = 10; // "light_indices": the light lists of the clusters
+    }
+
     // A forward renderer is a renderer that draw the object final color directly to the framebuffer
     // In other words, the fragment shader in the material should output the color that we should see on the screen
     // This is different from more complex renderers that could draw intermediate data to a framebuffer before computing the final color
@@ -32,32 +131,127 @@ namespace our
     {
         // These window size will be used on multiple occasions (setting the viewport, computing the aspect ratio, etc.)
         glm::ivec2 windowSize;
-        // These are two vectors in which we will store the opaque and the transparent commands.
-        // We define them here (instead of being local to the "render" function) as an optimization to prevent reallocating them every frame
-        std::vector<RenderCommand> opaqueCommands;
-        std::vector<RenderCommand> transparentCommands;
+        // With dynamic resolution (enabled with "dynamicResolution" in the config), the scene is drawn to the bottom left part
+        // of the window sized targets (see RenderPacket::renderSize) then upscaled by the postprocessing.
+        DynamicResolution dynamicResolution;
+        // The packets in which we store the commands & the lights of the frames.
+        // We keep them (instead of building a new one every frame) as an optimization to prevent reallocating their vectors every frame.
+        // With pipelining (enabled with "pipelining" in the config), the packet of frame N is prepared by "packetWorker"
+        // while the packet of frame N-1 is drawn, so the two packets are used in turns.
+        RenderPacket packets[2];
+        int nextPacket = 0;
+        const RenderPacket *lastPacket = nullptr;
+        bool pipelining = false;
+        FrameWorker packetWorker;
+        // The mesh renderers of the commands of the packet being extracted (their LODs are picked by "extractPacket")
+        std::vector<MeshRendererComponent *> candidateRenderers;
+        bool culling = true;
+        // Level of detail: the LOD of each command is picked from the projected size of its bounding sphere
+        bool lodSelection = true;
+        float lodHysteresis = 0.1f;
+        // The buffers used to sort the commands by their sort keys (kept for the same reason, they are only used by "preparePacket")
+        std::vector<render_sort::Entry> sortEntries, sortScratch;
+        std::vector<RenderCommand> commandScratch;
         // Objects used for rendering a skybox
-        Mesh *skySphere;
-        TexturedMaterial *skyMaterial;
-        // Objects used for Postprocessing
-        GLuint postprocessFrameBuffer, postProcessVertexArray;
-        Texture2D *colorTarget, *depthTarget;
-        TexturedMaterial *postprocessMaterial;
-        // light components for max number of lights
-        // LightComponent lightComponents[8];
-        // is a vector of light components
+        Mesh *skySphere = nullptr;
+        TexturedMaterial *skyMaterial = nullptr;
+        // The passes of each frame are declared in a render graph (see "submitPacket"). Its transient textures (e.g. the scene color & depth
+        // with postprocessing or the OIT targets) come from the target pool, which the postprocessing also uses for its intermediate targets.
+        RenderGraph graph;
+        RenderTargetPool targetPool;
+        // Objects used for Postprocessing (an empty vertex array for the fullscreen triangles)
+        GLuint postProcessVertexArray;
+        // The postprocessing effects are compiled once in "initialize" and only the active one runs (see PostprocessChain)
+        PostprocessChain *postprocess = nullptr;
+        // The light components found by "extractPacket"
         std::vector<LightComponent *> lightComponents;
 
+        // The uniform buffer holding the frame data. It is filled once per frame before drawing.
+        UniformBuffer *frameDataBuffer = nullptr;
+        // Clustered lighting: the directional lights (and the lights that never fade) are global and come first in the light data,
+        // then the point & spot lights are assigned to the clusters (of the packet) whose lists are read by the lit shaders from buffer textures
+        TextureBuffer *lightDataBuffer = nullptr, *lightClusterBuffer = nullptr, *lightIndexBuffer = nullptr;
+        size_t maxLightIndices = 0;
+
+        // Instancing: runs of at least "minInstances" commands sharing a mesh & a material are drawn with a single instanced draw call
+        // whose model matrices are streamed through "instanceBuffer"
+        bool instancing = true;
+        int minInstances = 2;
+        InstanceBuffer *instanceBuffer = nullptr;
+        std::vector<InstanceData> instanceData;
+
+        // Depth prepass: the opaque lit commands are first drawn to the depth buffer only (with the DEPTH_ONLY variant of their shader)
+        // then they are shaded with GL_EQUAL & no depth writes so each pixel is shaded once whatever the overdraw
+        bool depthPrepass = false;
+        // The GPU time of each pass (enabled with "gpuTimers" in the config, see GPUPassTimers)
+        GPUPassTimers passTimers;
+
+        // Weighted blended order-independent transparency (enabled with "oit" in the config): the transparent commands whose shader has an OIT variant
+        // are accumulated in any order into two transient textures of the render graph then composited over the scene, so they are not sorted.
+        // The other transparent commands are still sorted back-to-front and drawn after the composite.
+        bool oit = false;
+        ShaderProgram *oitCompositeShader = nullptr;
+        PipelineState oitCompositeState;
+
+        // Occlusion culling (enabled with "occlusionCulling" in the config): the opaque commands whose bounding box was hidden
+        // the last time it was tested are only drawn if their box passes a new test (see OcclusionCulling)
+        OcclusionCulling occlusion;
+
+        // Fills the packet from the world: the camera, the commands & the lights (it returns the camera or null if the world has no camera)
+        CameraComponent *extractPacket(World *world, RenderPacket &packet);
+        // Culls the commands outside the camera frustum, fills the command queues and sorts them then assigns the lights to the clusters
+        // (the opaque commands by state then front-to-back and the transparent commands back-to-front unless they use the OIT pass)
+        void preparePacket(RenderPacket &packet);
+        // Draws the packet
+        void submitPacket(const RenderPacket &packet);
+        // Fills the frame data uniform buffer & the light buffer textures and binds them
+        void updateFrameBuffers(const RenderPacket &packet);
+        // Draws a single command (setting up its material & sending its matrices as uniforms)
+        // If "prepassed" is true, the commands drawn in the depth prepass only test the depth with GL_EQUAL.
+        // The flags of "passVariant" are added to the shader variant of the command (e.g. shader_variant::OIT for the OIT pass).
+        void drawCommand(const RenderCommand &command, const glm::mat4 &VP, bool prepassed, uint32_t passVariant);
+        // Draws the sorted commands, grouping the consecutive commands sharing a mesh & a material into instanced draws
+        void drawCommands(const std::vector<RenderCommand> &commands, const glm::mat4 &VP, bool prepassed = false,
+                          uint32_t passVariant = shader_variant::NONE);
+        // Returns true if the commands of the given material are drawn in the depth prepass
+        bool usesDepthPrepass(const Material *material) const;
+        // Draws the depth of the opaque commands that use the depth prepass
+        void drawDepthPrepass(const std::vector<RenderCommand> &commands);
+        // Tests the bounding boxes of the opaque commands against the depth buffer then draws the occluded commands under conditional rendering
+        void drawOcclusionTests(const RenderPacket &packet, const glm::mat4 &VP);
+        // Clears the OIT targets (bound by the render graph) and accumulates the OIT commands into them
+        void accumulateOIT(const std::vector<RenderCommand> &commands, const glm::mat4 &VP);
+        // Blends the resolved color of the OIT targets over the scene
+        void compositeOIT(Texture2D *accum, Texture2D *weights);
+        // Draws the sky sphere around the camera (behind everything)
+        void drawSky(const glm::vec3 &eye, const glm::mat4 &VP);
+        // Sorts the commands by their sort keys
+        void sortCommands(std::vector<RenderCommand> &commands);
+        // Sets up a lit material and sends the model matrices to its shader (the camera & lights come from the uniform buffers)
+        void setupLitMaterial(LightMaterial *material, const glm::mat4 &localToWorld, uint32_t variant);
+
     public:
         // Initialize the renderer including the sky and the Postprocessing objects.
         // windowSize is the width & height of the window (in pixels).
         void initialize(glm::ivec2 windowSize, const nlohmann::json &config);
         // Clean up the renderer
         void destroy();
-        // This function should be called every frame to draw the given world
+        // Searches the world for a camera, culls the commands outside its frustum, fills the opaque & transparent command lists and sorts them
+        // (without drawing them). It returns the camera or null if the world has no camera.
+        CameraComponent *collectCommands(World *world);
+        // Returns the number of commands of the last collected or drawn packet
+        size_t getCommandCount() const { return lastPacket ? lastPacket->getCommandCount() : 0; }
+        // This function should be called every frame to draw the given world.
+        // With pipelining, it draws the previous frame while the worker prepares this one (so the frames are shown one frame later).
         void render(World *world);
-        bool effectOne = false;
-        bool effectTwo = false;
+
+        // Selects the postprocessing effect with the given ID (as named in the "postprocess" config).
+        // Returns false (and keeps the current effect) if there is no such effect.
+        bool setPostprocessEffect(const std::string &effect);
+        // Goes back to the default postprocessing effect
+        void resetPostprocessEffect();
+        // Returns true if the default postprocessing effect is the active one
+        bool isDefaultPostprocessEffect() const { return !postprocess || postprocess->isDefaultEffect(); }
     };
 
 }
\ No newline at end of file
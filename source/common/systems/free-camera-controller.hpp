@@ -442,14 +442,13 @@ namespace our
                     app->addCoins(dis(gen));     //? adding extra random time  (5~10)
                     world->markForRemoval(coin); //? removing coin after collision detection
                     playAudio("coins.mp3");      //? playing audio at collision detection
-                    renderer->effectTwo = true;
+                    renderer->setPostprocessEffect("coin");
                     lastTimeTakenPostPreprocessed = (float)glfwGetTime();
                 }
             }
-            if (glfwGetTime() - lastTimeTakenPostPreprocessed >= 0.5f && (renderer->effectOne || renderer->effectTwo))
+            if (glfwGetTime() - lastTimeTakenPostPreprocessed >= 0.5f && !renderer->isDefaultPostprocessEffect())
             {
-                renderer->effectOne = false;
-                renderer->effectTwo = false;
+                renderer->resetPostprocessEffect();
                 lastTimeTakenPostPreprocessed = 0.0f;
             }
             if (
@@ -474,7 +473,7 @@ namespace our
             {
                 monkey->localTransform.position.y = 0;
             }
-            this->renderer->effectOne = true;
+            this->renderer->setPostprocessEffect("game-over");
             lastTimeTakenPostPreprocessed = (float)glfwGetTime();
             app->setGameState(GameState::GAME_OVER);
 
@@ -556,7 +555,7 @@ namespace our
 
         void restartLevel(World *world)
         {
-            this->renderer->effectOne = false;
+            this->renderer->resetPostprocessEffect();
             std::this_thread::sleep_for(std::chrono::milliseconds(3000));
             app->setGameState(GameState::PLAYING);
             int currentLives = app->getLives();
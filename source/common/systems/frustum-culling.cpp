@@ -0,0 +1,82 @@
+#include "frustum-culling.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OUR_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace our
+{
+
+    Frustum Frustum::fromViewProjection(const glm::mat4 &VP)
+    {
+        // Each plane is a sum or a difference of the last row of the matrix and one of the other rows (glm matrices are column major)
+        glm::vec4 rowX = glm::vec4(VP[0][0], VP[1][0], VP[2][0], VP[3][0]);
+        glm::vec4 rowY = glm::vec4(VP[0][1], VP[1][1], VP[2][1], VP[3][1]);
+        glm::vec4 rowZ = glm::vec4(VP[0][2], VP[1][2], VP[2][2], VP[3][2]);
+        glm::vec4 rowW = glm::vec4(VP[0][3], VP[1][3], VP[2][3], VP[3][3]);
+        Frustum frustum;
+        frustum.planes[0] = rowW + rowX;
+        frustum.planes[1] = rowW - rowX;
+        frustum.planes[2] = rowW + rowY;
+        frustum.planes[3] = rowW - rowY;
+        frustum.planes[4] = rowW + rowZ;
+        frustum.planes[5] = rowW - rowZ;
+        // The normals are normalized so the plane equation gives the signed distance (which is compared to the radius)
+        for (glm::vec4 &plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    size_t cullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, std::vector<uint8_t> &visible)
+    {
+        size_t count = spheres.size();
+        visible.resize(count);
+        size_t visibleCount = 0;
+        size_t index = 0;
+#if defined(OUR_USE_SSE)
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int plane = 0; plane < 6; plane++)
+        {
+            planeX[plane] = _mm_set1_ps(frustum.planes[plane].x);
+            planeY[plane] = _mm_set1_ps(frustum.planes[plane].y);
+            planeZ[plane] = _mm_set1_ps(frustum.planes[plane].z);
+            planeW[plane] = _mm_set1_ps(frustum.planes[plane].w);
+        }
+        for (; index + 4 <= count; index += 4)
+        {
+            __m128 x = _mm_loadu_ps(spheres.x.data() + index);
+            __m128 y = _mm_loadu_ps(spheres.y.data() + index);
+            __m128 z = _mm_loadu_ps(spheres.z.data() + index);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius.data() + index));
+            // A lane stays inside while its signed distance to every plane is at least -radius
+            __m128 inside = _mm_cmpeq_ps(x, x); // All ones (unless the center is NaN)
+            for (int plane = 0; plane < 6; plane++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[plane]), _mm_mul_ps(y, planeY[plane])),
+                                             _mm_add_ps(_mm_mul_ps(z, planeZ[plane]), planeW[plane]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                uint8_t laneVisible = (mask >> lane) & 1;
+                visible[index + lane] = laneVisible;
+                visibleCount += laneVisible;
+            }
+        }
+#endif
+        // The remaining spheres (or all of them without SSE)
+        for (; index < count; index++)
+        {
+            glm::vec3 center = {spheres.x[index], spheres.y[index], spheres.z[index]};
+            bool inside = true;
+            for (const glm::vec4 &plane : frustum.planes)
+                inside = inside && glm::dot(glm::vec3(plane), center) + plane.w >= -spheres.radius[index];
+            visible[index] = inside;
+            visibleCount += inside;
+        }
+        return visibleCount;
+    }
+
+}
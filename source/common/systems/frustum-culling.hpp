@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // The 6 planes of a camera frustum in world space. Each plane is (normal, distance) where the normal points inside the frustum
+    // so a point p is inside a plane if dot(normal, p) + distance >= 0.
+    struct Frustum
+    {
+        glm::vec4 planes[6]; // left, right, bottom, top, near, far
+
+        // Extracts the planes from a view-projection matrix (Gribb & Hartmann) and normalizes them
+        static Frustum fromViewProjection(const glm::mat4 &VP);
+    };
+
+    // A list of bounding spheres stored as a structure of arrays so 4 spheres can be tested against a plane at once
+    struct BoundingSpheres
+    {
+        std::vector<float> x, y, z, radius;
+
+        size_t size() const { return x.size(); }
+        void clear()
+        {
+            x.clear();
+            y.clear();
+            z.clear();
+            radius.clear();
+        }
+        void push(const glm::vec3 &center, float sphereRadius)
+        {
+            x.push_back(center.x);
+            y.push_back(center.y);
+            z.push_back(center.z);
+            radius.push_back(sphereRadius);
+        }
+    };
+
+    // Tests every sphere against the frustum and writes 1 (visible) or 0 (outside) per sphere in "visible".
+    // A sphere is visible unless it is completely behind one of the planes, so spheres near the corners may be kept (never wrongly culled).
+    // Returns the number of visible spheres.
+    size_t cullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, std::vector<uint8_t> &visible);
+
+}
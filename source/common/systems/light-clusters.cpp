@@ -0,0 +1,119 @@
+#include "light-clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace our
+{
+
+    void LightClusters::build(const std::vector<glm::vec4> &lights, const glm::mat4 &V, const glm::mat4 &P, bool perspective,
+                              float near, float far, size_t maxIndices)
+    {
+        // An orthographic camera has no meaningful depth range so all the lights share a single slice
+        int slices = perspective ? gridSize.z : 1;
+        float logNear = std::log(near), logRange = std::log(far / near);
+        depthScale = perspective ? slices / logRange : 0.0f;
+        depthBias = perspective ? -slices * logNear / logRange : 0.0f;
+        auto slice = [&](float depth)
+        { return std::clamp((int)std::floor(std::log(depth) * depthScale + depthBias), 0, slices - 1); };
+        auto tile = [](float ndc, int count)
+        { return std::clamp((int)std::floor((ndc * 0.5f + 0.5f) * count), 0, count - 1); };
+
+        // First pass: find the cluster bounds of each light and count the lights of each cluster
+        std::vector<uint32_t> counts(getClusterCount(), 0);
+        lightBounds.resize(lights.size());
+        size_t lightCount = std::min(lights.size(), MAX_LIGHTS);
+        for (size_t light = 0; light < lightCount; light++)
+        {
+            LightBounds &bounds = lightBounds[light];
+            bounds.min = glm::ivec3(0);
+            bounds.max = glm::ivec3(-1);
+            glm::vec3 center = glm::vec3(V * glm::vec4(glm::vec3(lights[light]), 1.0f));
+            float radius = lights[light].w;
+            float minDepth = -center.z - radius, maxDepth = -center.z + radius;
+            if (perspective)
+            {
+                if (maxDepth <= near || minDepth >= far)
+                    continue;
+                bounds.min.z = slice(std::max(minDepth, near));
+                bounds.max.z = slice(std::min(maxDepth, far));
+            }
+            else
+            {
+                bounds.max.z = 0;
+            }
+
+            // The screen bounds are the projection of the 8 corners of the box around the sphere.
+            // A sphere that crosses the near plane of a perspective camera covers the whole screen (conservatively).
+            bounds.max.x = gridSize.x - 1;
+            bounds.max.y = gridSize.y - 1;
+            if (!perspective || minDepth > near)
+            {
+                glm::vec2 ndcMin(INFINITY), ndcMax(-INFINITY);
+                for (int corner = 0; corner < 8; corner++)
+                {
+                    glm::vec3 offset = {corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius};
+                    glm::vec4 clip = P * glm::vec4(center + offset, 1.0f);
+                    glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                    ndcMin = glm::min(ndcMin, ndc);
+                    ndcMax = glm::max(ndcMax, ndc);
+                }
+                if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+                {
+                    bounds.max = glm::ivec3(-1);
+                    continue;
+                }
+                bounds.min.x = tile(ndcMin.x, gridSize.x);
+                bounds.max.x = tile(ndcMax.x, gridSize.x);
+                bounds.min.y = tile(ndcMin.y, gridSize.y);
+                bounds.max.y = tile(ndcMax.y, gridSize.y);
+            }
+
+            for (int z = bounds.min.z; z <= bounds.max.z; z++)
+                for (int y = bounds.min.y; y <= bounds.max.y; y++)
+                    for (int x = bounds.min.x; x <= bounds.max.x; x++)
+                        counts[x + gridSize.x * (y + gridSize.y * z)]++;
+        }
+
+        // The lists are packed one after the other (the clusters past "maxIndices" lose their extra lights)
+        ranges.resize(counts.size());
+        uint32_t offset = 0;
+        for (size_t cluster = 0; cluster < counts.size(); cluster++)
+        {
+            uint32_t count = (uint32_t)std::min<size_t>(counts[cluster], maxIndices - std::min<size_t>(offset, maxIndices));
+            ranges[cluster] = {offset, 0};
+            counts[cluster] = count;
+            offset += count;
+        }
+
+        // Second pass: fill the lists
+        indices.resize(offset);
+        for (size_t light = 0; light < lightCount; light++)
+        {
+            const LightBounds &bounds = lightBounds[light];
+            for (int z = bounds.min.z; z <= bounds.max.z; z++)
+                for (int y = bounds.min.y; y <= bounds.max.y; y++)
+                    for (int x = bounds.min.x; x <= bounds.max.x; x++)
+                    {
+                        glm::uvec2 &range = ranges[x + gridSize.x * (y + gridSize.y * z)];
+                        if (range.y < counts[x + gridSize.x * (y + gridSize.y * z)])
+                            indices[range.x + range.y++] = (uint16_t)light;
+                    }
+        }
+    }
+
+    float computeLightRange(const glm::vec3 &attenuation, const glm::vec3 &diffuse, const glm::vec3 &specular)
+    {
+        // Solve x*d^2 + y*d + z = 256 * intensity for the positive root
+        float intensity = std::max({diffuse.x, diffuse.y, diffuse.z, specular.x, specular.y, specular.z});
+        float target = 256.0f * intensity - attenuation.z;
+        if (target <= 0.0f)
+            return 0.0f;
+        if (attenuation.x > 0.0f)
+            return (-attenuation.y + std::sqrt(attenuation.y * attenuation.y + 4.0f * attenuation.x * target)) / (2.0f * attenuation.x);
+        if (attenuation.y > 0.0f)
+            return target / attenuation.y;
+        return INFINITY;
+    }
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // The view frustum is divided into a grid of clusters ("froxels"): "x" by "y" screen tiles and "z" depth slices
+    // whose thickness grows exponentially with the depth (so the clusters stay roughly cubic).
+    // Each cluster gets the list of the local lights whose sphere of influence touches it, so a fragment only loops over the lights of its cluster.
+    class LightClusters
+    {
+        glm::ivec3 gridSize = {16, 9, 24};
+        // The depth slice of a view depth d is floor(log(d) * depthScale + depthBias)
+        float depthScale = 0.0f, depthBias = 0.0f;
+        // The lights of each cluster are "indices[offset .. offset + count)" where "ranges[cluster]" is (offset, count).
+        // The indices are positions in the list given to "build" (the shader adds the number of global lights stored before them).
+        std::vector<glm::uvec2> ranges;
+        std::vector<uint16_t> indices;
+        // The cluster bounds of each light (computed by the counting pass & reused by the filling pass)
+        struct LightBounds
+        {
+            glm::ivec3 min, max;
+        };
+        std::vector<LightBounds> lightBounds;
+
+    public:
+        // The maximum number of local lights (the light indices are 16-bit)
+        static constexpr size_t MAX_LIGHTS = 65535;
+
+        void setGridSize(glm::ivec3 size) { gridSize = glm::max(size, glm::ivec3(1)); }
+        glm::ivec3 getGridSize() const { return gridSize; }
+        // Returns (depthScale, depthBias) so the shader computes the same depth slices
+        glm::vec2 getDepthSliceParameters() const { return {depthScale, depthBias}; }
+        int getClusterCount() const { return gridSize.x * gridSize.y * gridSize.z; }
+
+        // Assigns the lights to the clusters of the given camera. Each light is a world space sphere (xyz: center, w: radius).
+        // "V" & "P" are the view & projection matrices of the camera and "near" & "far" are its clipping distances (for a perspective camera).
+        // An orthographic camera gets a single depth slice. At most "maxIndices" light indices are stored (the extra ones are dropped).
+        void build(const std::vector<glm::vec4> &lights, const glm::mat4 &V, const glm::mat4 &P, bool perspective,
+                   float near, float far, size_t maxIndices);
+
+        const std::vector<glm::uvec2> &getRanges() const { return ranges; }
+        const std::vector<uint16_t> &getIndices() const { return indices; }
+    };
+
+    // Returns the distance after which the light of a point or a spot light drops below 1/256 of its peak intensity,
+    // where the attenuation is 1 / (x*d^2 + y*d + z). Returns infinity if the light never fades (x = y = 0).
+    float computeLightRange(const glm::vec3 &attenuation, const glm::vec3 &diffuse, const glm::vec3 &specular);
+
+}
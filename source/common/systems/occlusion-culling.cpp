@@ -0,0 +1,170 @@
+#include "occlusion-culling.hpp"
+#include "../render-stats.hpp"
+#include "../gl-state.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace our
+{
+
+    namespace uniforms
+    {
+        static constexpr UniformID transform("transform");
+    }
+
+    // The slots that were not requested for this many frames are freed. It is more than one frame since,
+    // with pipelining, a packet is drawn one frame after its slots were requested.
+    static constexpr uint64_t SLOT_LIFETIME = 2;
+
+    void OcclusionCulling::initialize(const nlohmann::json &config)
+    {
+        enabled = config.is_boolean() && config.get<bool>();
+        if (!enabled)
+            return;
+        proxyShader = new ShaderProgram();
+        proxyShader->attach("assets/shaders/occlusion-proxy.vert", GL_VERTEX_SHADER);
+        proxyShader->attach("assets/shaders/occlusion-proxy.frag", GL_FRAGMENT_SHADER);
+        proxyShader->link();
+        glGenVertexArrays(1, &proxyVertexArray);
+        // The boxes are tested against the depth of the opaque objects without writing anything.
+        // Both sides are drawn and GL_LEQUAL is used so a box touching the surface of its object still passes.
+        proxyState.depthTesting.enabled = true;
+        proxyState.depthTesting.function = GL_LEQUAL;
+        proxyState.colorMask = {false, false, false, false};
+        proxyState.depthMask = false;
+    }
+
+    void OcclusionCulling::destroy()
+    {
+        for (Slot &slot : slots)
+        {
+            glDeleteQueries(1, &slot.query);
+            if (slot.conditionalQuery)
+                glDeleteQueries(1, &slot.conditionalQuery);
+        }
+        slots.clear();
+        freeSlots.clear();
+        slotOfObject.clear();
+        if (proxyShader)
+        {
+            delete proxyShader;
+            proxyShader = nullptr;
+            glDeleteVertexArrays(1, &proxyVertexArray);
+            GLState::onVertexArrayDeleted(proxyVertexArray);
+        }
+        enabled = false;
+    }
+
+    void OcclusionCulling::beginFrame()
+    {
+        frame++;
+        for (auto it = slotOfObject.begin(); it != slotOfObject.end();)
+        {
+            if (frame - slots[it->second].lastUsed > SLOT_LIFETIME)
+            {
+                // The query is kept for the next object that gets the slot
+                freeSlots.push_back(it->second);
+                it = slotOfObject.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    uint32_t OcclusionCulling::getSlot(const void *object)
+    {
+        auto [it, inserted] = slotOfObject.try_emplace(object, 0);
+        if (inserted)
+        {
+            if (freeSlots.empty())
+            {
+                it->second = (uint32_t)slots.size();
+                slots.emplace_back();
+                glGenQueries(1, &slots.back().query);
+            }
+            else
+            {
+                it->second = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            // A new object knows nothing about its visibility (a pending result of the previous owner is dropped)
+            Slot &slot = slots[it->second];
+            slot.pending = false;
+            slot.visible = true;
+            slot.tested = false;
+        }
+        slots[it->second].lastUsed = frame;
+        return it->second;
+    }
+
+    void OcclusionCulling::collectResults()
+    {
+        for (Slot &slot : slots)
+        {
+            if (!slot.pending)
+                continue;
+            GLint ready = GL_FALSE;
+            glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &ready);
+            if (!ready)
+                continue;
+            GLuint samples = 0;
+            glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT, &samples);
+            slot.visible = samples != 0;
+            slot.pending = false;
+        }
+    }
+
+    void OcclusionCulling::beginProxies()
+    {
+        proxyState.setup();
+        proxyShader->use();
+        GLState::bindVertexArray(proxyVertexArray);
+    }
+
+    bool OcclusionCulling::drawProxy(uint32_t slot, const glm::mat4 &transform, const MeshBounds &bounds, bool conditional)
+    {
+        Slot &state = slots[slot];
+        if (state.pending && !conditional)
+            return false;
+        // The result of a pending query can't be replaced before it is read, so the conditional draws get a query of their own
+        GLuint query = state.query;
+        if (state.pending)
+        {
+            if (!state.conditionalQuery)
+                glGenQueries(1, &state.conditionalQuery);
+            query = state.conditionalQuery;
+        }
+        // The unit cube is scaled to the bounding box grown by 1% of its size (and a bit more so the flat meshes get a thickness)
+        glm::vec3 padding = (bounds.max - bounds.min) * 0.01f + 1e-3f;
+        glm::vec3 origin = bounds.min - padding, size = bounds.max - bounds.min + 2.0f * padding;
+        glm::mat4 box = glm::scale(glm::translate(glm::mat4(1.0f), origin), size);
+        proxyShader->set(uniforms::transform, transform * box);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 14);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        RenderStats::current().drawCalls++;
+        RenderStats::current().triangles += 12;
+        RenderStats::current().occlusionQueries++;
+        state.pending = true;
+        state.tested = true;
+        state.lastQuery = query;
+        return true;
+    }
+
+    bool OcclusionCulling::beginConditionalRender(uint32_t slot)
+    {
+        if (!slots[slot].tested)
+            return false;
+        // The GPU (not the CPU) waits for the result of the query which was issued just before by "drawProxy"
+        glBeginConditionalRender(slots[slot].lastQuery, GL_QUERY_WAIT);
+        return true;
+    }
+
+    void OcclusionCulling::endConditionalRender()
+    {
+        glEndConditionalRender();
+    }
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+#include "../shader/shader.hpp"
+#include "../material/pipeline-state.hpp"
+#include "../mesh/mesh.hpp"
+
+namespace our
+{
+
+    // Skips the opaque objects hidden behind other objects using occlusion queries on their bounding boxes.
+    // Each object (identified by its mesh renderer) gets a slot holding a GL_ANY_SAMPLES_PASSED query. After the opaque pass,
+    // the bounding boxes are drawn against the depth buffer (without writing anything) and the results are read in a later frame
+    // (once they are available) so the CPU never waits for the GPU. The objects whose last result says "hidden" are not drawn
+    // with the opaque commands: their box is tested again in the same frame with a fresh query (the second query of the slot
+    // if the first one is still in flight) and they are drawn inside glBeginConditionalRender on that query,
+    // so the GPU drops them if the box is still hidden and draws them in the same frame if it was revealed (without popping).
+    class OcclusionCulling
+    {
+        struct Slot
+        {
+            GLuint query = 0;
+            // The query issued for the conditional draws while "query" is still pending (its result is only used by the GPU)
+            GLuint conditionalQuery = 0;
+            // The last issued query (the one used by the conditional draws)
+            GLuint lastQuery = 0;
+            // True while the result of "query" is not read yet (it is not issued again until then)
+            bool pending = false;
+            // The last read result (the objects are assumed to be visible until they are tested)
+            bool visible = true;
+            // True once a query was issued (so it can be used for conditional rendering)
+            bool tested = false;
+            uint64_t lastUsed = 0;
+        };
+
+        bool enabled = false;
+        std::unordered_map<const void *, uint32_t> slotOfObject;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        uint64_t frame = 0;
+
+        // The boxes are generated by the vertex shader from gl_VertexID so they need no vertex buffer
+        ShaderProgram *proxyShader = nullptr;
+        GLuint proxyVertexArray = 0;
+        PipelineState proxyState;
+
+    public:
+        static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+        // Reads the config ("occlusionCulling": true or false)
+        void initialize(const nlohmann::json &config);
+        void destroy();
+        bool isEnabled() const { return enabled; }
+
+        // Called once per frame before the slots are requested. The slots that were not requested for a few frames are freed.
+        void beginFrame();
+        // Returns the slot of the given object (creating it if needed)
+        uint32_t getSlot(const void *object);
+        // Returns the last read result of the slot
+        bool isVisible(uint32_t slot) const { return slots[slot].visible; }
+
+        // Reads the results of the queries that are done (without waiting for the others)
+        void collectResults();
+        // Sets up the pipeline state & the shader of the proxies
+        void beginProxies();
+        // Draws the bounding box of an object (whose model-view-projection matrix is "transform") inside the query of its slot.
+        // If the query of the slot is still pending, nothing is drawn unless "conditional" is true (the object will be drawn
+        // with "beginConditionalRender" in this frame) where the box is drawn inside the second query of the slot.
+        // Returns true if a query was issued.
+        bool drawProxy(uint32_t slot, const glm::mat4 &transform, const MeshBounds &bounds, bool conditional = false);
+        // The draws between these two calls are dropped by the GPU if the last query issued for the slot found no samples.
+        // Returns false (and starts nothing) if the slot was never tested.
+        bool beginConditionalRender(uint32_t slot);
+        void endConditionalRender();
+    };
+
+}
@@ -0,0 +1,254 @@
+#include "postprocess-chain.hpp"
+#include "../render-stats.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace our
+{
+
+    // The FXAA quality presets (the uniforms of "assets/shaders/postprocess/fxaa.frag")
+    static nlohmann::json getFXAAPreset(const std::string &preset)
+    {
+        if (preset == "low")
+            return {{"edge_threshold", 0.25f}, {"edge_threshold_min", 0.0833f}, {"subpixel", 0.5f}, {"search_steps", 4.0f}};
+        if (preset == "high")
+            return {{"edge_threshold", 0.125f}, {"edge_threshold_min", 0.0312f}, {"subpixel", 1.0f}, {"search_steps", 12.0f}};
+        if (preset != "medium")
+            std::cerr << "Unknown FXAA preset \"" << preset << "\" (the medium preset is used instead)" << std::endl;
+        return {{"edge_threshold", 0.166f}, {"edge_threshold_min", 0.0625f}, {"subpixel", 0.75f}, {"search_steps", 8.0f}};
+    }
+
+    void PostprocessChain::initialize(const nlohmann::json &config, RenderTargetPool *pool)
+    {
+        this->pool = pool;
+        // The inputs are sampled with linear filtering so the downsampled passes are upsampled smoothly by the next pass
+        sampler = new Sampler();
+        sampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        sampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        sampler->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        sampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // The passes don't interact with the depth buffer
+        pipelineState.depthMask = false;
+
+        std::string defaultName = "default";
+        if (config.is_string())
+        {
+            effects[defaultName] = loadEffect(config);
+        }
+        else if (config.is_object())
+        {
+            // The luma is computed once by its own pass then read with the color by the FXAA pass
+            const nlohmann::json &fxaa = config.value("fxaa", nlohmann::json(false));
+            if (fxaa.is_string() || fxaa.is_object() || (fxaa.is_boolean() && fxaa.get<bool>()))
+            {
+                nlohmann::json uniforms = fxaa.is_object() ? fxaa : getFXAAPreset(fxaa.is_string() ? fxaa.get<std::string>() : "medium");
+                prelude.push_back({{"shader", "assets/shaders/postprocess/luma.frag"}});
+                prelude.push_back({{"shader", "assets/shaders/postprocess/fxaa.frag"}, {"uniforms", uniforms}});
+            }
+            defaultName = config.value("default", defaultName);
+            for (auto &[name, effect] : config.value("effects", nlohmann::json::object()).items())
+                effects[name] = loadEffect(effect);
+        }
+        if (auto it = effects.find(defaultName); it != effects.end())
+            defaultEffect = &it->second;
+        else
+            std::cerr << "The default postprocess effect \"" << defaultName << "\" is not defined" << std::endl;
+        activeEffect = defaultEffect;
+    }
+
+    PostprocessEffect PostprocessChain::loadEffect(const nlohmann::json &data)
+    {
+        PostprocessEffect effect;
+        std::vector<std::string> names;
+        nlohmann::json passes = prelude;
+        for (auto &passData : (data.is_array() ? data : nlohmann::json::array({data})))
+            passes.push_back(passData);
+        for (auto &passData : passes)
+        {
+            bool detailed = passData.is_object();
+            if (detailed && !passData.value("enabled", true))
+                continue;
+            std::string fragmentShader = detailed ? passData.value("shader", "") : passData.get<std::string>();
+            std::string vertexShader = detailed ? passData.value("vs", "assets/shaders/fullscreen.vert") : "assets/shaders/fullscreen.vert";
+
+            PostprocessPass pass;
+            pass.shader = getShader(vertexShader, fragmentShader);
+            if (detailed)
+                pass.scale = std::clamp(passData.value("scale", 1.0f), 1.0f / 16.0f, 1.0f);
+
+            // Each input reads the scene, the previous pass or an earlier pass by name (by default, "tex" reads the previous pass).
+            // After the prelude, the scene is the output of the prelude.
+            int previous = effect.empty() ? PostprocessPass::SCENE : (int)effect.size() - 1;
+            int scene = effect.size() < prelude.size() ? PostprocessPass::SCENE : (int)prelude.size() - 1;
+            nlohmann::json inputs = detailed ? passData.value("inputs", nlohmann::json::object()) : nlohmann::json::object();
+            if (inputs.empty())
+                inputs["tex"] = "previous";
+            for (auto &[samplerName, sourceData] : inputs.items())
+            {
+                std::string source = sourceData.get<std::string>();
+                int index = previous;
+                if (source == "scene")
+                    index = scene;
+                else if (source != "previous")
+                {
+                    auto it = std::find(names.begin(), names.end(), source);
+                    if (it == names.end())
+                        std::cerr << "Unknown postprocess pass \"" << source << "\" (the previous pass is used instead)" << std::endl;
+                    else
+                        index = (int)(it - names.begin());
+                }
+                pass.inputs.push_back({UniformID(samplerName), index});
+            }
+
+            if (detailed)
+            {
+                for (auto &[uniformName, value] : passData.value("uniforms", nlohmann::json::object()).items())
+                {
+                    std::vector<float> values = value.is_array() ? value.get<std::vector<float>>() : std::vector<float>{value.get<float>()};
+                    if (values.empty() || values.size() > 4)
+                        std::cerr << "The postprocess uniform \"" << uniformName << "\" must have 1 to 4 values" << std::endl;
+                    else
+                        pass.uniforms.push_back({UniformID(uniformName), values});
+                }
+            }
+
+            names.push_back(detailed ? passData.value("name", "") : "");
+            effect.push_back(std::move(pass));
+        }
+
+        // The target of each pass is kept until its last reader is done
+        for (int index = 0; index < (int)effect.size(); index++)
+            for (auto &[samplerName, source] : effect[index].inputs)
+                if (source != PostprocessPass::SCENE)
+                    effect[source].lastReader = std::max(effect[source].lastReader, index);
+        return effect;
+    }
+
+    ShaderProgram *PostprocessChain::getShader(const std::string &vertexShader, const std::string &fragmentShader)
+    {
+        ShaderProgram *&shader = shaders[vertexShader + "|" + fragmentShader];
+        if (!shader)
+        {
+            shader = new ShaderProgram();
+            shader->attach(vertexShader, GL_VERTEX_SHADER);
+            shader->attach(fragmentShader, GL_FRAGMENT_SHADER);
+            shader->link();
+        }
+        return shader;
+    }
+
+    void PostprocessChain::destroy()
+    {
+        for (auto &[key, shader] : shaders)
+            delete shader;
+        shaders.clear();
+        effects.clear();
+        prelude = nlohmann::json::array();
+        defaultEffect = activeEffect = nullptr;
+        pool = nullptr;
+        delete sampler;
+        sampler = nullptr;
+    }
+
+    bool PostprocessChain::setEffect(const std::string &effect)
+    {
+        auto it = effects.find(effect);
+        if (it == effects.end())
+            return false;
+        activeEffect = &it->second;
+        return true;
+    }
+
+    void PostprocessChain::render(GLuint sceneFramebuffer, Texture2D *scene, glm::ivec2 sceneSize, glm::ivec2 windowSize, GLuint vertexArray)
+    {
+        // Without any pass, the scene is copied as is (and upscaled with linear filtering if needed)
+        bool upscale = sceneSize != windowSize;
+        GLenum filter = upscale ? GL_LINEAR : GL_NEAREST;
+        if (!activeEffect || activeEffect->empty())
+        {
+            GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+            GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, sceneSize.x, sceneSize.y, 0, 0, windowSize.x, windowSize.y, GL_COLOR_BUFFER_BIT, filter);
+            glViewport(0, 0, windowSize.x, windowSize.y);
+            return;
+        }
+
+        // The passes read their inputs over the whole texture so a smaller scene is first upscaled to a window sized target
+        RenderTarget *upscaled = nullptr;
+        if (upscale)
+        {
+            upscaled = pool->acquire(windowSize);
+            GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+            GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, upscaled->framebuffer);
+            glBlitFramebuffer(0, 0, sceneSize.x, sceneSize.y, 0, 0, windowSize.x, windowSize.y, GL_COLOR_BUFFER_BIT, filter);
+            scene = upscaled->texture;
+        }
+
+        const PostprocessEffect &effect = *activeEffect;
+        outputs.assign(effect.size(), nullptr);
+        pipelineState.setup();
+        GLState::bindVertexArray(vertexArray);
+        for (size_t index = 0; index < effect.size(); index++)
+        {
+            const PostprocessPass &pass = effect[index];
+            glm::ivec2 size = windowSize;
+            if (index + 1 < effect.size())
+            {
+                size = glm::max(glm::ivec2(glm::vec2(windowSize) * pass.scale + 0.5f), glm::ivec2(1));
+                outputs[index] = pool->acquire(size);
+                GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, outputs[index]->framebuffer);
+            }
+            else
+            {
+                GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            }
+            glViewport(0, 0, size.x, size.y);
+
+            pass.shader->use();
+            for (GLint unit = 0; unit < (GLint)pass.inputs.size(); unit++)
+            {
+                auto &[samplerName, source] = pass.inputs[unit];
+                GLState::activeTexture(GL_TEXTURE0 + unit);
+                (source == PostprocessPass::SCENE ? scene : outputs[source]->texture)->bind();
+                sampler->bind(unit);
+                pass.shader->set(samplerName, unit);
+            }
+            for (auto &[uniform, values] : pass.uniforms)
+            {
+                switch (values.size())
+                {
+                case 1:
+                    pass.shader->set(uniform, values[0]);
+                    break;
+                case 2:
+                    pass.shader->set(uniform, glm::vec2(values[0], values[1]));
+                    break;
+                case 3:
+                    pass.shader->set(uniform, glm::vec3(values[0], values[1], values[2]));
+                    break;
+                default:
+                    pass.shader->set(uniform, glm::vec4(values[0], values[1], values[2], values[3]));
+                    break;
+                }
+            }
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            RenderStats::current().drawCalls++;
+            RenderStats::current().triangles++;
+
+            // The targets that no later pass reads go back to the pool (so the next passes can reuse them)
+            for (size_t source = 0; source <= index; source++)
+            {
+                if (outputs[source] && effect[source].lastReader <= (int)index)
+                {
+                    pool->release(outputs[source]);
+                    outputs[source] = nullptr;
+                }
+            }
+        }
+        if (upscaled)
+            pool->release(upscaled);
+        glViewport(0, 0, windowSize.x, windowSize.y);
+    }
+
+}
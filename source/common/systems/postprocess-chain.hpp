@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+#include "../shader/shader.hpp"
+#include "../texture/sampler.hpp"
+#include "../texture/render-target-pool.hpp"
+#include "../material/pipeline-state.hpp"
+
+namespace our
+{
+
+    // A fullscreen pass of a postprocess effect
+    struct PostprocessPass
+    {
+        // The input source of the scene color (the other sources are the indices of the earlier passes of the effect)
+        static constexpr int SCENE = -1;
+
+        ShaderProgram *shader = nullptr;
+        // The size of the output relative to the window (e.g. 0.5 to blur at half resolution). The last pass always draws to the window.
+        float scale = 1.0f;
+        // The sampler uniform of each input and its source
+        std::vector<std::pair<UniformID, int>> inputs;
+        // The constant uniforms of the pass (1 to 4 floats each)
+        std::vector<std::pair<UniformID, std::vector<float>>> uniforms;
+        // The index of the last pass that reads the output of this pass (its target goes back to the pool after it)
+        int lastReader = -1;
+    };
+
+    // An effect is an ordered list of passes (an empty effect just copies the scene to the window)
+    using PostprocessEffect = std::vector<PostprocessPass>;
+
+    // The postprocess effects described by the "postprocess" config of the renderer. Only the active effect runs (one pass per enabled pass)
+    // and the intermediate results ping-pong between the reusable targets of a RenderTargetPool. The config is either:
+    //  - the path of a single fragment shader, or
+    //  - { "default": "vignette", "effects": { "vignette": <effect>, ... } } where an effect is a fragment shader path, a pass or a list of passes:
+    //      { "shader": "assets/shaders/postprocess/radial-blur.frag", // The fragment shader (the vertex shader is "fullscreen.vert" unless "vs" is given)
+    //        "name": "blur",                                          // Lets the later passes read this pass by name
+    //        "scale": 0.5,                                            // The resolution of the output relative to the window
+    //        "inputs": { "tex": "previous" },                         // Sampler uniform -> "scene", "previous" (the default) or a pass name
+    //        "uniforms": { "strength": 0.3 },                         // Numbers or arrays of 2 to 4 numbers
+    //        "enabled": true }                                        // The disabled passes are skipped (and not even compiled)
+    // The object config can also enable the anti-aliasing with "fxaa": "low", "medium", "high" or an object of the uniforms of "fxaa.frag".
+    // The luma & FXAA passes then run before the passes of every effect (whose "scene" input becomes the anti-aliased scene).
+    class PostprocessChain
+    {
+        std::unordered_map<std::string, PostprocessEffect> effects;
+        // The passes run before the passes of each effect (the anti-aliasing)
+        nlohmann::json prelude = nlohmann::json::array();
+        // The programs are shared by the passes using the same shaders (the key is the vertex & the fragment shader paths)
+        std::unordered_map<std::string, ShaderProgram *> shaders;
+        const PostprocessEffect *defaultEffect = nullptr, *activeEffect = nullptr;
+        // The intermediate targets are taken from the pool of the renderer (shared with its render graph)
+        RenderTargetPool *pool = nullptr;
+        std::vector<RenderTarget *> outputs;
+        Sampler *sampler = nullptr;
+        PipelineState pipelineState;
+
+        PostprocessEffect loadEffect(const nlohmann::json &data);
+        ShaderProgram *getShader(const std::string &vertexShader, const std::string &fragmentShader);
+
+    public:
+        void initialize(const nlohmann::json &config, RenderTargetPool *pool);
+        void destroy();
+
+        // Selects the effect with the given ID. Returns false (and keeps the current effect) if there is no such effect.
+        bool setEffect(const std::string &effect);
+        // Goes back to the default effect
+        void resetEffect() { activeEffect = defaultEffect; }
+        bool isDefaultEffect() const { return activeEffect == defaultEffect; }
+
+        // Applies the active effect to the scene color (drawn in "sceneFramebuffer") and draws the result to the default framebuffer.
+        // The scene covers the bottom left "sceneSize" pixels of its target (less than the window with dynamic resolution) and is upscaled first.
+        // "vertexArray" is an empty vertex array used to draw the fullscreen triangles.
+        void render(GLuint sceneFramebuffer, Texture2D *scene, glm::ivec2 sceneSize, glm::ivec2 windowSize, GLuint vertexArray);
+    };
+
+}
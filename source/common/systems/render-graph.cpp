@@ -0,0 +1,180 @@
+#include "render-graph.hpp"
+#include "../gl-state.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace our
+{
+
+    void RenderGraph::initialize(RenderTargetPool *pool)
+    {
+        this->pool = pool;
+        reset();
+    }
+
+    void RenderGraph::destroy()
+    {
+        deleteFramebuffers();
+        resources.clear();
+        passes.clear();
+        pool = nullptr;
+    }
+
+    void RenderGraph::deleteFramebuffers()
+    {
+        for (auto &[attachments, framebuffer] : framebuffers)
+        {
+            glDeleteFramebuffers(1, &framebuffer);
+            GLState::onFramebufferDeleted(framebuffer);
+        }
+        framebuffers.clear();
+    }
+
+    void RenderGraph::reset()
+    {
+        resources.clear();
+        passes.clear();
+        Resource backbuffer;
+        backbuffer.name = "backbuffer";
+        backbuffer.size = {0, 0};
+        backbuffer.format = GL_NONE;
+        resources.push_back(backbuffer);
+    }
+
+    RenderGraph::ResourceID RenderGraph::createTexture(const std::string &name, glm::ivec2 size, GLenum format)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.size = size;
+        resource.format = format;
+        resources.push_back(resource);
+        return (ResourceID)resources.size() - 1;
+    }
+
+    RenderGraph::PassID RenderGraph::addPass(const std::string &name, std::function<void(const RenderGraph &)> execute)
+    {
+        Pass pass;
+        pass.name = name;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+        return (PassID)passes.size() - 1;
+    }
+
+    void RenderGraph::read(PassID pass, ResourceID resource)
+    {
+        std::vector<ResourceID> &reads = passes[pass].reads;
+        if (std::find(reads.begin(), reads.end(), resource) == reads.end())
+            reads.push_back(resource);
+    }
+
+    void RenderGraph::write(PassID pass, ResourceID resource)
+    {
+        std::vector<ResourceID> &writes = passes[pass].writes;
+        if (std::find(writes.begin(), writes.end(), resource) == writes.end())
+            writes.push_back(resource);
+    }
+
+    void RenderGraph::compile()
+    {
+        // The lifetime of each texture spans from the first to the last pass that uses it
+        for (Resource &resource : resources)
+            resource.firstUse = resource.lastUse = -1;
+        for (PassID step = 0; step < (PassID)passes.size(); step++)
+        {
+            for (ResourceID resource : passes[step].reads)
+                if (resources[resource].firstUse < 0)
+                    std::cerr << "The pass \"" << passes[step].name << "\" reads \"" << resources[resource].name << "\" before any pass writes it" << std::endl;
+            for (auto *uses : {&passes[step].reads, &passes[step].writes})
+            {
+                for (ResourceID resource : *uses)
+                {
+                    if (resources[resource].firstUse < 0)
+                        resources[resource].firstUse = step;
+                    resources[resource].lastUse = step;
+                }
+            }
+        }
+    }
+
+    GLuint RenderGraph::getFramebuffer(const Pass &pass)
+    {
+        if (std::find(pass.writes.begin(), pass.writes.end(), BACKBUFFER) != pass.writes.end())
+            return 0;
+        std::vector<GLuint> key;
+        GLenum colorAttachment = GL_COLOR_ATTACHMENT0;
+        for (ResourceID resource : pass.writes)
+        {
+            GLenum attachment = isDepthFormat(resources[resource].format) ? GL_DEPTH_ATTACHMENT : colorAttachment++;
+            key.push_back(attachment);
+            key.push_back(resources[resource].target->texture->getOpenGLName());
+        }
+        auto it = framebuffers.find(key);
+        if (it != framebuffers.end())
+            return it->second;
+
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (size_t index = 0; index < key.size(); index += 2)
+        {
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, key[index], GL_TEXTURE_2D, key[index + 1], 0);
+            if (key[index] != GL_DEPTH_ATTACHMENT)
+                drawBuffers.push_back(key[index]);
+        }
+        if (drawBuffers.empty())
+            glDrawBuffer(GL_NONE);
+        else
+            glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+        framebuffers[key] = framebuffer;
+        return framebuffer;
+    }
+
+    void RenderGraph::execute(GPUPassTimers *timers)
+    {
+        // The cached framebuffers may reference the textures of the targets the pool deleted since they were created
+        if (pool->getGeneration() != poolGeneration)
+        {
+            deleteFramebuffers();
+            poolGeneration = pool->getGeneration();
+        }
+        for (int step = 0; step < (int)passes.size(); step++)
+        {
+            Pass &pass = passes[step];
+            // The textures starting their lifetime take a free target of their size & format (its content is undefined)
+            for (auto *uses : {&pass.reads, &pass.writes})
+            {
+                for (ResourceID resource : *uses)
+                {
+                    Resource &texture = resources[resource];
+                    if (resource != BACKBUFFER && texture.firstUse == step && !texture.target)
+                        texture.target = pool->acquire(texture.size, texture.format);
+                }
+            }
+            if (!pass.writes.empty())
+                GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, getFramebuffer(pass));
+
+            if (timers)
+                timers->begin(pass.name);
+            pass.execute(*this);
+            if (timers)
+                timers->end();
+
+            // The textures ending their lifetime give their targets back so the next textures can alias them
+            for (auto *uses : {&pass.reads, &pass.writes})
+            {
+                for (ResourceID resource : *uses)
+                {
+                    Resource &texture = resources[resource];
+                    if (texture.lastUse == step && texture.target)
+                    {
+                        pool->release(texture.target);
+                        texture.target = nullptr;
+                    }
+                }
+            }
+        }
+    }
+
+}
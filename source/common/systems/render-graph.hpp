@@ -0,0 +1,91 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "../texture/render-target-pool.hpp"
+#include "../gpu-pass-timers.hpp"
+
+namespace our
+{
+
+    // A small render graph rebuilt every frame. The renderer declares its textures and its passes, and each pass declares
+    // the textures it samples ("read") and the textures it draws to ("write", which become the attachments of its framebuffer).
+    // "execute" runs the passes in the order they were added (a pass can only depend on the passes added before it). There is no culling:
+    // the passes that are not needed in a frame are simply not added. The declared textures are transient: each one is taken from
+    // a RenderTargetPool right before its first pass and given back right after its last pass, so the textures whose lifetimes
+    // don't overlap share the same target when their sizes & formats match. The framebuffers of the attachment sets are cached
+    // until the pool deletes some of its targets.
+    class RenderGraph
+    {
+    public:
+        using ResourceID = int;
+        using PassID = int;
+
+        // The default framebuffer (the window). It always exists.
+        // A pass writing it draws to the default framebuffer and can't write any other texture.
+        static constexpr ResourceID BACKBUFFER = 0;
+
+    private:
+        struct Resource
+        {
+            std::string name;
+            glm::ivec2 size;
+            GLenum format;
+            // The first & the last passes that use the resource
+            int firstUse = -1, lastUse = -1;
+            // The target holding the texture while the resource is alive
+            RenderTarget *target = nullptr;
+        };
+        struct Pass
+        {
+            std::string name;
+            std::function<void(const RenderGraph &)> execute;
+            std::vector<ResourceID> reads, writes;
+        };
+
+        RenderTargetPool *pool = nullptr;
+        std::vector<Resource> resources;
+        std::vector<Pass> passes;
+        // The framebuffer of each set of attachments (the key is the attachment & the texture name of each attached texture)
+        std::map<std::vector<GLuint>, GLuint> framebuffers;
+        // The generation of the pool when the framebuffers were cached (they are deleted once the pool deletes some targets
+        // since the names of the deleted textures can be reused by new ones)
+        uint64_t poolGeneration = 0;
+
+        GLuint getFramebuffer(const Pass &pass);
+        void deleteFramebuffers();
+
+    public:
+        // The textures are taken from the given pool (which may be shared with other users, e.g. the PostprocessChain)
+        void initialize(RenderTargetPool *pool);
+        // Deletes the cached framebuffers (the targets belong to the pool)
+        void destroy();
+
+        // Removes all the passes & the textures (but the backbuffer) to build the graph of a new frame
+        void reset();
+        // Declares a transient texture
+        ResourceID createTexture(const std::string &name, glm::ivec2 size, GLenum format);
+        // Declares a pass. "execute" is called by "execute" with the framebuffer of the written textures bound.
+        PassID addPass(const std::string &name, std::function<void(const RenderGraph &)> execute);
+        // Declares that the pass samples the texture
+        void read(PassID pass, ResourceID resource);
+        // Declares that the pass draws to the texture (the color textures are attached in the order they are written)
+        void write(PassID pass, ResourceID resource);
+        // Computes the lifetimes of the textures (and warns about the textures read before they are written)
+        void compile();
+        // Runs the passes (timing each one with the given timers if any)
+        void execute(GPUPassTimers *timers = nullptr);
+
+        // Returns the target of a texture. It is only valid inside the passes that use the texture.
+        const RenderTarget *getTarget(ResourceID resource) const { return resources[resource].target; }
+        Texture2D *getTexture(ResourceID resource) const { return resources[resource].target->texture; }
+        size_t getPassCount() const { return passes.size(); }
+    };
+
+}
@@ -0,0 +1,52 @@
+#include "render-sort.hpp"
+
+namespace our::render_sort
+{
+
+    void radixSort(std::vector<Entry> &entries, std::vector<Entry> &scratch)
+    {
+        size_t count = entries.size();
+        // For a handful of entries, the histograms cost more than a comparison sort
+        if (count <= 32)
+        {
+            std::stable_sort(entries.begin(), entries.end(), [](const Entry &first, const Entry &second)
+                             { return first.key < second.key; });
+            return;
+        }
+        scratch.resize(count);
+
+        // Build the histograms of the 8 bytes in a single pass over the keys
+        uint32_t histograms[8][256] = {};
+        for (const Entry &entry : entries)
+            for (int byte = 0; byte < 8; byte++)
+                histograms[byte][(entry.key >> (8 * byte)) & 0xFF]++;
+
+        Entry *source = entries.data(), *destination = scratch.data();
+        for (int byte = 0; byte < 8; byte++)
+        {
+            uint32_t *histogram = histograms[byte];
+            int shift = 8 * byte;
+            // If all the keys have the same value in this byte, this pass would not move anything
+            if (histogram[(source[0].key >> shift) & 0xFF] == count)
+                continue;
+            // Turn the counts into the first output position of each digit
+            uint32_t offset = 0;
+            for (int digit = 0; digit < 256; digit++)
+            {
+                uint32_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                const Entry &entry = source[i];
+                destination[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+            }
+            std::swap(source, destination);
+        }
+        // After an odd number of passes, the sorted entries are in the scratch buffer
+        if (source != entries.data())
+            entries.swap(scratch);
+    }
+
+}
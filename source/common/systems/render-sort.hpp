@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace our
+{
+
+    // A 64-bit render sort key packs everything that decides the draw order of a command so sorting the keys is enough to order the draws.
+    // Opaque keys:      | pass (4) | shader (12) | material (16) | mesh (12) | depth (20) |
+    //   which groups the draws by state (so the shader, textures & VAO change as rarely as possible) then draws them front-to-back
+    //   (so the early depth test rejects as many hidden fragments as possible).
+    // Transparent keys: | pass (4) | inverted depth (24) | shader (12) | material (16) | mesh (8) |
+    //   which draws back-to-front (as required by blending) and only groups the draws that are at the same depth.
+    // The IDs are the "getSortID" of the objects truncated to the width of their fields, so two objects sharing the truncated ID
+    // are only drawn in a slightly worse order.
+    namespace render_sort
+    {
+
+        // The passes occupy the highest bits so all the commands of a pass are drawn before the next pass
+        // (the names avoid OPAQUE & TRANSPARENT which are macros on Windows)
+        enum class Pass : uint64_t
+        {
+            OPAQUE_PASS = 0,
+            TRANSPARENT_PASS = 1
+        };
+
+        // Quantizes a normalized depth (0 at the near plane & 1 at the far plane) to the given number of bits
+        inline uint64_t quantizeDepth(float depth, int bits)
+        {
+            uint64_t maximum = (uint64_t(1) << bits) - 1;
+            return (uint64_t)(std::clamp(depth, 0.0f, 1.0f) * (float)maximum);
+        }
+
+        inline uint64_t opaqueKey(uint32_t shader, uint32_t material, uint32_t mesh, float depth)
+        {
+            return (uint64_t)Pass::OPAQUE_PASS << 60 |
+                   uint64_t(shader & 0xFFF) << 48 |
+                   uint64_t(material & 0xFFFF) << 32 |
+                   uint64_t(mesh & 0xFFF) << 20 |
+                   quantizeDepth(depth, 20);
+        }
+
+        inline uint64_t transparentKey(uint32_t shader, uint32_t material, uint32_t mesh, float depth)
+        {
+            return (uint64_t)Pass::TRANSPARENT_PASS << 60 |
+                   ((uint64_t(1) << 24) - 1 - quantizeDepth(depth, 24)) << 36 |
+                   uint64_t(shader & 0xFFF) << 24 |
+                   uint64_t(material & 0xFFFF) << 8 |
+                   uint64_t(mesh & 0xFF);
+        }
+
+        // A key and the index of the command it was computed for
+        struct Entry
+        {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        // Sorts the entries by key in ascending order using a stable LSD radix sort (8 passes of 8 bits).
+        // The passes whose byte is the same for all the keys are skipped, so the cost is O(n * number of distinct bytes).
+        // "scratch" is a buffer owned by the caller so sorting every frame does not allocate.
+        void radixSort(std::vector<Entry> &entries, std::vector<Entry> &scratch);
+
+        // Reorders "items" such that items[i] becomes items[entries[i].index] (after sorting the entries, this orders the items by key).
+        // "scratch" is a buffer owned by the caller and is swapped with "items".
+        template <typename T>
+        void applyOrder(const std::vector<Entry> &entries, std::vector<T> &items, std::vector<T> &scratch)
+        {
+            scratch.resize(items.size());
+            for (size_t i = 0; i < entries.size(); i++)
+                scratch[i] = items[entries[i].index];
+            items.swap(scratch);
+        }
+
+    }
+
+}
@@ -0,0 +1,86 @@
+#include "render-target-pool.hpp"
+#include "texture-utils.hpp"
+
+namespace our
+{
+
+    RenderTarget *RenderTargetPool::acquire(glm::ivec2 size, GLenum format)
+    {
+        for (Entry *entry : entries)
+        {
+            if (!entry->used && entry->target.size == size && entry->target.format == format)
+            {
+                entry->used = true;
+                entry->lastUsed = frame;
+                return &entry->target;
+            }
+        }
+
+        Entry *entry = new Entry();
+        entry->used = true;
+        entry->lastUsed = frame;
+        RenderTarget &target = entry->target;
+        target.size = size;
+        target.format = format;
+        target.texture = texture_utils::empty(format, size);
+        glGenFramebuffers(1, &target.framebuffer);
+        GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, target.framebuffer);
+        GLenum attachment = isDepthFormat(format) ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0;
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, target.texture->getOpenGLName(), 0);
+        entries.push_back(entry);
+        return &target;
+    }
+
+    void RenderTargetPool::release(RenderTarget *target)
+    {
+        for (Entry *entry : entries)
+        {
+            if (&entry->target == target)
+            {
+                entry->used = false;
+                return;
+            }
+        }
+    }
+
+    static void deleteTarget(RenderTarget &target)
+    {
+        glDeleteFramebuffers(1, &target.framebuffer);
+        GLState::onFramebufferDeleted(target.framebuffer);
+        delete target.texture;
+    }
+
+    void RenderTargetPool::clear()
+    {
+        for (Entry *entry : entries)
+        {
+            deleteTarget(entry->target);
+            delete entry;
+        }
+        if (!entries.empty())
+            generation++;
+        entries.clear();
+    }
+
+    void RenderTargetPool::trim(uint64_t maxIdleFrames)
+    {
+        size_t kept = 0;
+        for (Entry *entry : entries)
+        {
+            if (!entry->used && frame - entry->lastUsed > maxIdleFrames)
+            {
+                deleteTarget(entry->target);
+                delete entry;
+            }
+            else
+            {
+                entries[kept++] = entry;
+            }
+        }
+        if (kept != entries.size())
+            generation++;
+        entries.resize(kept);
+        frame++;
+    }
+
+}
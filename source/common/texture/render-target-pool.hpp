@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "texture2d.hpp"
+
+namespace our
+{
+
+    // Returns true if the internal format is a depth (or depth stencil) format
+    inline bool isDepthFormat(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32:
+        case GL_DEPTH_COMPONENT32F:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH32F_STENCIL8:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // A texture attached to its own framebuffer (as its color attachment or as its depth attachment for the depth formats)
+    struct RenderTarget
+    {
+        GLuint framebuffer = 0;
+        Texture2D *texture = nullptr;
+        glm::ivec2 size = {0, 0};
+        GLenum format = GL_RGBA8;
+    };
+
+    // A pool of render targets reused between the passes of a frame and between the frames.
+    // A pass acquires a target with the size & format it needs and releases it once the later passes are done reading it,
+    // so a chain of passes ping-pongs between a few targets instead of allocating one per pass.
+    class RenderTargetPool
+    {
+        struct Entry
+        {
+            RenderTarget target;
+            bool used = false;
+            uint64_t lastUsed = 0;
+        };
+        std::vector<Entry *> entries;
+        uint64_t frame = 0;
+        // Incremented whenever targets are deleted (so the users caching framebuffers of the textures know when to drop them)
+        uint64_t generation = 0;
+
+    public:
+        // Returns an unused target with the given size & format (creating it if there is none)
+        RenderTarget *acquire(glm::ivec2 size, GLenum format = GL_RGBA8);
+        // Returns the target to the pool (its content is kept until it is acquired again)
+        void release(RenderTarget *target);
+        // Deletes all the targets
+        void clear();
+        // Called once per frame: deletes the unused targets that were not acquired for more than "maxIdleFrames" frames
+        // (e.g. the targets of the old size after the window or the render size changed) so the memory stays bounded
+        void trim(uint64_t maxIdleFrames = 2);
+        // Returns the number of targets created by the pool
+        size_t getTargetCount() const { return entries.size(); }
+        uint64_t getGeneration() const { return generation; }
+
+        ~RenderTargetPool() { clear(); }
+    };
+
+}
@@ -4,6 +4,8 @@
 #include <json/json.hpp>
 #include <glm/vec4.hpp>
 
+#include "../gl-state.hpp"
+
 namespace our
 {
 
@@ -26,20 +28,21 @@ namespace our
         {
             // DONE: (Req 6) Complete this function
             glDeleteSamplers(1, &name);
+            GLState::onSamplerDeleted(name);
         }
 
         // This method binds this sampler to the given texture unit
         void bind(GLuint textureUnit) const
         {
             // DONE: (Req 6) Complete this function
-            glBindSampler(textureUnit, name);
+            GLState::bindSampler(textureUnit, name);
         }
 
         // This static method ensures that no sampler is bound to the given texture unit
         static void unbind(GLuint textureUnit)
         {
             // DONE: (Req 6) Complete this function
-            glBindSampler(textureUnit, 0);
+            GLState::bindSampler(textureUnit, 0);
         }
 
         // This function sets a sampler paramter where the value is of type "GLint"
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+
+#include <glad/gl.h>
+
+#include "../render-stats.hpp"
+#include "../gl-state.hpp"
+
+namespace our
+{
+
+    // This class wraps a buffer texture (GL_TEXTURE_BUFFER): a buffer object read by the shaders with "texelFetch" on a samplerBuffer.
+    // It is used for the per-frame data that is too big for a uniform block (e.g. the light lists of the clusters).
+    class TextureBuffer
+    {
+        GLuint buffer, texture;
+        GLsizeiptr capacity = 0;
+
+    public:
+        // "internalFormat" is the format of a texel (e.g. GL_RGBA32F or GL_R16UI)
+        TextureBuffer(GLenum internalFormat)
+        {
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+            capacity = 16;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, buffer);
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+        ~TextureBuffer()
+        {
+            glDeleteTextures(1, &texture);
+            GLState::onTextureDeleted(texture);
+            glDeleteBuffers(1, &buffer);
+        }
+
+        // Replaces the content of the buffer with "bytes" bytes (growing it if needed).
+        // The old storage is orphaned first so the driver doesn't wait for the draw calls of the last frame that still read it.
+        void update(const void *data, GLsizeiptr bytes)
+        {
+            capacity = std::max(capacity, bytes);
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+            if (bytes > 0)
+                glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            RenderStats::current().bytesUploaded += bytes;
+        }
+
+        // Binds the buffer texture to the given texture unit
+        void bind(GLuint unit) const
+        {
+            GLState::activeTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+        }
+
+        TextureBuffer(const TextureBuffer &) = delete;
+        TextureBuffer &operator=(const TextureBuffer &) = delete;
+    };
+
+}
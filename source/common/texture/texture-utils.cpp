@@ -45,6 +45,7 @@ our::Texture2D *our::texture_utils::loadImage(const std::string &filename, bool
     texture->bind();
     // upload the image data to the texture
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    RenderStats::current().bytesUploaded += (uint64_t)size.x * size.y * 4;
     //check if we want to generate mipmaps
     if (generate_mipmap)
     {
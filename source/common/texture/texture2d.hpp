@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glad/gl.h>
+#include "../gl-state.hpp"
 
 namespace our
 {
@@ -26,6 +27,7 @@ namespace our
             // DONE: (Req 5) Complete this function
             // delete this texture
             glDeleteTextures(1, &name);
+            GLState::onTextureDeleted(name);
         }
 
         // Get the internal OpenGL name of the texture which is useful for use with framebuffers
@@ -39,7 +41,7 @@ namespace our
         {
             // DONE: (Req 5) Complete this function
             // bind this texture to GL_TEXTURE_2D
-            glBindTexture(GL_TEXTURE_2D, name);
+            GLState::bindTexture2D(name);
         }
 
         // This static method ensures that no texture is bound to GL_TEXTURE_2D
@@ -47,7 +49,7 @@ namespace our
         {
             // DONE: (Req 5) Complete this function
             // unbind any texture from GL_TEXTURE_2D
-            glBindTexture(GL_TEXTURE_2D, 0);
+            GLState::bindTexture2D(0);
         }
 
         Texture2D(const Texture2D &) = delete;
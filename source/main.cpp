@@ -1,9 +1,11 @@
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 #include <flags/flags.h>
 #include <json/json.hpp>
 
 #include <application.hpp>
+#include <stress-scene.hpp>
 
 #include "states/menu-state.hpp"
 #include "states/play-state.hpp"
@@ -17,6 +19,7 @@
 #include "states/material-test-state.hpp"
 #include "states/entity-test-state.hpp"
 #include "states/renderer-test-state.hpp"
+#include "states/stress-test-state.hpp"
 
 int main(int argc, char **argv)
 {
@@ -40,6 +43,64 @@ int main(int argc, char **argv)
     nlohmann::json app_config = nlohmann::json::parse(file_in, nullptr, true, true);
     file_in.close();
 
+    // bench turns "-f" into a benchmark mode using the "benchmark" block of the config (see "frame-benchmark.hpp")
+    // The options "-warmup", "-dt", "-vsync" & "-bench-out" override the values of the block
+    // The report goes to "benchmarks/" under the path of the config relative to "config/" unless the block or "-bench-out" says otherwise
+    // Default: false where the frames are not measured
+    if (args.get<bool>("bench", false))
+    {
+        auto &benchmark = app_config["benchmark"];
+        benchmark["enabled"] = true;
+        if (auto warmup = args.get<int>("warmup"))
+            benchmark["warmup"] = *warmup;
+        if (auto fixed_delta = args.get<double>("dt"))
+            benchmark["fixed-delta"] = *fixed_delta;
+        if (auto vsync = args.get<bool>("vsync"))
+            benchmark["vsync"] = *vsync;
+        if (auto output = args.get<std::string>("bench-out"))
+            benchmark["output"] = *output;
+        if (!benchmark.contains("output"))
+        {
+            // e.g. "config/renderer-test/test-0.jsonc" -> "benchmarks/renderer-test/test-0.json"
+            std::filesystem::path relative = std::filesystem::path(config_path).lexically_relative("config");
+            if (relative.empty() || *relative.begin() == "..")
+                relative = std::filesystem::path(config_path).filename();
+            benchmark["output"] = (std::filesystem::path("benchmarks") / relative.replace_extension(".json")).generic_string();
+        }
+    }
+
+    // stress is the approximate number of entities of a generated stress scene that replaces the world of the config
+    // The generated scene uses the assets & renderer of the config (so it should be "config/game.jsonc" or similar)
+    // The generator parameters can be overridden one by one using the options below
+    // Default: 0 where no scene is generated
+    if (int stress = args.get<int>("stress", 0); stress > 0)
+    {
+        our::stress_scene::Parameters parameters = our::stress_scene::forEntityCount(stress);
+        parameters.lanes = args.get<int>("lanes").value_or(parameters.lanes);
+        parameters.carsPerLane = args.get<int>("cars").value_or(parameters.carsPerLane);
+        parameters.trunks = args.get<int>("trunks").value_or(parameters.trunks);
+        parameters.coins = args.get<int>("coins").value_or(parameters.coins);
+        parameters.lights = args.get<int>("lights").value_or(parameters.lights);
+        parameters.transparent = args.get<int>("transparent").value_or(parameters.transparent);
+        parameters.hierarchyDepth = args.get<int>("depth").value_or(parameters.hierarchyDepth);
+        parameters.lampsPerLane = args.get<int>("lamps").value_or(parameters.lampsPerLane);
+        parameters.headlights = args.get<bool>("headlights").value_or(parameters.headlights);
+        parameters.seed = args.get<unsigned int>("seed").value_or(parameters.seed);
+        app_config["scene"]["world"] = our::stress_scene::generate(parameters);
+        app_config["start-scene"] = "stress-test";
+        // If requested, save the generated config so it can be run again (or inspected) with "-c"
+        if (std::string stress_out = args.get<std::string>("stress-out", ""); !stress_out.empty())
+        {
+            std::ofstream file_out(stress_out);
+            if (!file_out)
+            {
+                std::cerr << "Couldn't open file: " << stress_out << std::endl;
+                return -1;
+            }
+            file_out << app_config.dump(2) << std::endl;
+        }
+    }
+
     // Create the application
     our::Application app(app_config);
 
@@ -56,6 +117,7 @@ int main(int argc, char **argv)
     app.registerState<MaterialTestState>("material-test");
     app.registerState<EntityTestState>("entity-test");
     app.registerState<RendererTestState>("renderer-test");
+    app.registerState<StressTestState>("stress-test");
     // Then choose the state to run based on the option "start-scene" in the config
     if (app_config.contains(std::string{"start-scene"}))
     {
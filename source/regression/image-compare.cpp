@@ -0,0 +1,115 @@
+#include "image-compare.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include <stb/stb_image.h>
+#include <stb/stb_image_write.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OUR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+size_t our::regression::countMismatches(const uint8_t *a, const uint8_t *b, size_t pixels, uint8_t tolerance, uint8_t &maxDifference)
+{
+    size_t mismatched = 0;
+    size_t pixel = 0;
+    uint8_t maximum = 0;
+#if defined(OUR_USE_SSE2)
+    const __m128i toleranceVector = _mm_set1_epi8((char)tolerance);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i maximumVector = zero;
+    for (; pixel + 4 <= pixels; pixel += 4)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + 4 * pixel));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + 4 * pixel));
+        // |a - b| for unsigned bytes is the saturated difference in both directions
+        __m128i difference = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        maximumVector = _mm_max_epu8(maximumVector, difference);
+        // A channel exceeds the tolerance if (difference - tolerance) does not saturate to zero
+        __m128i excess = _mm_subs_epu8(difference, toleranceVector);
+        // A pixel matches if all its 4 channels (32 bits) have no excess
+        int matching = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(excess, zero)));
+        static const uint8_t zeros[16] = {4, 3, 3, 2, 3, 2, 2, 1, 3, 2, 2, 1, 2, 1, 1, 0}; // 4 - popcount
+        mismatched += zeros[matching];
+    }
+    alignas(16) uint8_t lanes[16];
+    _mm_store_si128((__m128i *)lanes, maximumVector);
+    maximum = *std::max_element(lanes, lanes + 16);
+#endif
+    // The remaining pixels (or all of them if SSE2 is not available)
+    for (; pixel < pixels; pixel++)
+    {
+        bool mismatch = false;
+        for (int channel = 0; channel < 4; channel++)
+        {
+            int index = 4 * (int)pixel + channel;
+            uint8_t difference = (uint8_t)std::abs((int)a[index] - (int)b[index]);
+            maximum = std::max(maximum, difference);
+            mismatch |= difference > tolerance;
+        }
+        mismatched += mismatch;
+    }
+    maxDifference = maximum;
+    return mismatched;
+}
+
+our::regression::ImageComparison our::regression::compareImages(const std::string &expectedPath, const std::string &outputPath, float tolerance, const std::string &diffPath)
+{
+    ImageComparison result;
+    using ImageData = std::unique_ptr<stbi_uc, decltype(&stbi_image_free)>;
+    int width, height, channels;
+    // The images are compared as RGBA so images with & without alpha can be compared (the missing alpha is 255)
+    stbi_set_flip_vertically_on_load(false);
+    ImageData expected(stbi_load(expectedPath.c_str(), &width, &height, &channels, 4), stbi_image_free);
+    if (!expected)
+    {
+        result.error = "Couldn't load the expected image: " + expectedPath;
+        return result;
+    }
+    int outputWidth, outputHeight;
+    ImageData output(stbi_load(outputPath.c_str(), &outputWidth, &outputHeight, &channels, 4), stbi_image_free);
+    if (!output)
+    {
+        result.error = "Couldn't load the output image: " + outputPath;
+        return result;
+    }
+    if (width != outputWidth || height != outputHeight)
+    {
+        result.error = "Size mismatch: expected " + std::to_string(width) + "x" + std::to_string(height) +
+                       " but got " + std::to_string(outputWidth) + "x" + std::to_string(outputHeight);
+        return result;
+    }
+
+    result.loaded = true;
+    result.width = width;
+    result.height = height;
+    uint8_t toleranceByte = (uint8_t)std::clamp(tolerance * 255.0f, 0.0f, 255.0f);
+    size_t pixels = (size_t)width * height;
+    result.mismatched = countMismatches(expected.get(), output.get(), pixels, toleranceByte, result.maxDifference);
+
+    if (result.mismatched > 0 && !diffPath.empty())
+    {
+        // The diff is the expected image darkened with the mismatched pixels drawn in red
+        std::vector<uint8_t> diff(pixels * 3);
+        for (size_t pixel = 0; pixel < pixels; pixel++)
+        {
+            const uint8_t *e = expected.get() + 4 * pixel, *o = output.get() + 4 * pixel;
+            bool mismatch = false;
+            for (int channel = 0; channel < 4; channel++)
+                mismatch |= std::abs((int)e[channel] - (int)o[channel]) > toleranceByte;
+            for (int channel = 0; channel < 3; channel++)
+                diff[3 * pixel + channel] = mismatch ? (channel == 0 ? 255 : 0) : e[channel] / 4;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(diffPath).parent_path(), ec);
+        // The screenshots flip the images on write so we make sure this one is written as is
+        stbi_flip_vertically_on_write(false);
+        stbi_write_png(diffPath.c_str(), width, height, 3, diff.data(), width * 3);
+    }
+    return result;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace our::regression
+{
+
+    // The result of comparing an output image with its expected image
+    struct ImageComparison
+    {
+        bool loaded = false;      // False if any of the two images couldn't be loaded or their sizes don't match
+        std::string error;        // Why the comparison failed to run (if "loaded" is false)
+        int width = 0, height = 0;
+        size_t mismatched = 0;    // Number of pixels where any channel differs by more than the tolerance
+        uint8_t maxDifference = 0; // The largest difference found in any channel
+    };
+
+    // Counts the pixels (4 bytes each) where any channel of "a" and "b" differs by more than "tolerance".
+    // It also returns the largest channel difference in "maxDifference".
+    // This is the hot loop of the comparison so it processes 4 pixels at a time using SSE2 when available.
+    size_t countMismatches(const uint8_t *a, const uint8_t *b, size_t pixels, uint8_t tolerance, uint8_t &maxDifference);
+
+    // Compares two image files where "tolerance" is the allowed channel difference in the range [0, 1] (same as imgcmp).
+    // If "diffPath" is not empty and some pixels mismatched, an image marking the mismatched pixels in red is written to it.
+    ImageComparison compareImages(const std::string &expectedPath, const std::string &outputPath, float tolerance, const std::string &diffPath = "");
+
+}
@@ -0,0 +1,240 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <flags/flags.h>
+#include <json/json.hpp>
+
+#include <application.hpp>
+
+#include "../states/shader-test-state.hpp"
+#include "../states/mesh-test-state.hpp"
+#include "../states/transform-test-state.hpp"
+#include "../states/pipeline-test-state.hpp"
+#include "../states/texture-test-state.hpp"
+#include "../states/sampler-test-state.hpp"
+#include "../states/material-test-state.hpp"
+#include "../states/entity-test-state.hpp"
+#include "../states/renderer-test-state.hpp"
+
+#include "image-compare.hpp"
+
+// An application whose window is hidden so the test scenes are rendered offscreen
+class RegressionApplication : public our::Application
+{
+    void configureOpenGL() override
+    {
+        our::Application::configureOpenGL();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
+public:
+    RegressionApplication(const nlohmann::json &app_config) : our::Application(app_config)
+    {
+        registerState<ShaderTestState>("shader-test");
+        registerState<MeshTestState>("mesh-test");
+        registerState<TransformTestState>("transform-test");
+        registerState<PipelineTestState>("pipeline-test");
+        registerState<TextureTestState>("texture-test");
+        registerState<SamplerTestState>("sampler-test");
+        registerState<MaterialTestState>("material-test");
+        registerState<EntityTestState>("entity-test");
+        registerState<RendererTestState>("renderer-test");
+    }
+};
+
+static nlohmann::json readJson(const std::string &path)
+{
+    std::ifstream file_in(path);
+    if (!file_in)
+        return nullptr;
+    return nlohmann::json::parse(file_in, nullptr, true, true);
+}
+
+// This executable runs all the test configs in one process, compares their screenshots with the expected images
+// and compares their frame times with the stored baselines. It prints a json report and returns the number of failures.
+// A config without a stored baseline is reported (and warned about) but can't regress, so "-update-baselines" should be run
+// on the reference machine whenever a config is added. The benchmark budgets of the configs are checked too (see "frame-benchmark.hpp").
+// Options:
+//  -c      the regression config listing the tests, their tolerances & the timing settings (Default: "config/regression.jsonc")
+//  -o      a file to which the json report is written (Default: "<output>/report.json")
+//  -filter only run the configs whose path contains this string (Default: "" which runs everything)
+//  -update-baselines   store the measured frame times as the new baselines instead of comparing with them
+//  -no-timing          only check the images (useful on machines that are too noisy for timing)
+int main(int argc, char **argv)
+{
+    flags::args args(argc, argv);
+    std::string config_path = args.get<std::string>("c", "config/regression.jsonc");
+    std::string filter = args.get<std::string>("filter", "");
+    bool update_baselines = args.get<bool>("update-baselines", false);
+    bool check_timing = !args.get<bool>("no-timing", false);
+
+    nlohmann::json config = readJson(config_path);
+    if (config.is_null())
+    {
+        std::cerr << "Couldn't open file: " << config_path << std::endl;
+        return -1;
+    }
+    std::filesystem::path output_directory = config.value("output", "regression");
+    std::string report_path = args.get<std::string>("o", (output_directory / "report.json").string());
+    nlohmann::json timing = config.value("timing", nlohmann::json::object());
+    std::string baselines_path = timing.value("baselines", "expected/timing-baselines.json");
+    double timing_tolerance = timing.value("tolerance", 0.25);
+    nlohmann::json baselines = readJson(baselines_path);
+    if (!baselines.is_object())
+        baselines = nlohmann::json::object();
+
+    nlohmann::json results = nlohmann::json::array();
+    int visual_failures = 0, timing_regressions = 0, budget_failures = 0;
+    std::vector<std::string> missing_baselines;
+
+    for (auto &test : config["tests"])
+    {
+        std::string name = test["name"].get<std::string>();
+        float tolerance = test.value("tolerance", 0.01f);
+        size_t threshold = test.value("threshold", 0);
+
+        // The configs are sorted so the report order is the same on every platform
+        std::vector<std::string> test_configs;
+        for (auto &entry : std::filesystem::directory_iterator("config/" + name))
+            if (entry.path().extension() == ".jsonc")
+                test_configs.push_back(entry.path().generic_string());
+        std::sort(test_configs.begin(), test_configs.end());
+
+        for (auto &test_config_path : test_configs)
+        {
+            if (test_config_path.find(filter) == std::string::npos)
+                continue;
+            nlohmann::json app_config = readJson(test_config_path);
+
+            // Redirect the screenshots to the output directory and run in the benchmark mode to measure the frames
+            // (the other settings of the config's benchmark block, e.g. its budgets, are kept)
+            auto screenshot_directory = output_directory / "screenshots" / name;
+            app_config["screenshots"]["directory"] = screenshot_directory.string();
+            app_config["benchmark"].update({
+                {"enabled", check_timing},
+                {"frames", timing.value("frames", 60)},
+                {"warmup", timing.value("warmup", 10)},
+                {"vsync", false}});
+
+            int run_for_frames = 2; // Enough for the screenshots at frame 1 when the timing is disabled
+            if (auto &requests = app_config["screenshots"]["requests"]; requests.is_array())
+                for (auto &request : requests)
+                    run_for_frames = std::max(run_for_frames, request.value("frame", 0) + 1);
+
+            RegressionApplication app(app_config);
+            app.changeState(app_config["start-scene"].get<std::string>());
+            int exit_code = app.run(check_timing ? 0 : run_for_frames);
+
+            nlohmann::json result = {{"config", test_config_path}, {"exit-code", exit_code}};
+            bool passed = exit_code == 0;
+            // The run fails if it couldn't start or (in the benchmark mode) if it exceeded a budget of its config
+            if (!passed)
+            {
+                ++budget_failures;
+                std::cerr << "Run failed: " << test_config_path << " (exit code " << exit_code << ")" << std::endl;
+            }
+
+            // Compare every requested screenshot with its expected image
+            nlohmann::json images = nlohmann::json::array();
+            for (auto &request : app_config["screenshots"]["requests"])
+            {
+                std::string file = request.value("file", "");
+                auto expected_path = std::filesystem::path("expected") / name / file;
+                auto comparison = our::regression::compareImages(
+                    expected_path.string(),
+                    (screenshot_directory / file).string(),
+                    tolerance,
+                    (output_directory / "errors" / name / file).string());
+                bool matched = comparison.loaded && comparison.mismatched <= threshold;
+                nlohmann::json image = {{"file", file}, {"passed", matched}};
+                if (comparison.loaded)
+                {
+                    image["mismatched"] = comparison.mismatched;
+                    image["max-difference"] = comparison.maxDifference;
+                }
+                else
+                {
+                    image["error"] = comparison.error;
+                }
+                images.push_back(image);
+                if (!matched)
+                {
+                    passed = false;
+                    ++visual_failures;
+                    std::cerr << "Visual regression: " << test_config_path << " (" << file << ")" << std::endl;
+                }
+            }
+            result["images"] = images;
+
+            // Compare the median frame time with the baseline
+            if (check_timing)
+            {
+                double median = app.getFrameTimings().percentile(50);
+                nlohmann::json frame_timing = app.getFrameTimings().toJson();
+                if (update_baselines)
+                {
+                    baselines[test_config_path] = median;
+                }
+                else if (baselines.contains(test_config_path))
+                {
+                    double baseline = baselines[test_config_path].get<double>();
+                    bool regressed = median > baseline * (1.0 + timing_tolerance);
+                    frame_timing["baseline"] = baseline;
+                    frame_timing["ratio"] = baseline > 0 ? median / baseline : 0.0;
+                    frame_timing["regressed"] = regressed;
+                    if (regressed)
+                    {
+                        passed = false;
+                        ++timing_regressions;
+                        std::cerr << "Timing regression: " << test_config_path << " took " << median << " ms instead of " << baseline << " ms" << std::endl;
+                    }
+                }
+                else
+                {
+                    frame_timing["baseline"] = "missing";
+                    missing_baselines.push_back(test_config_path);
+                    std::cerr << "Missing timing baseline: " << test_config_path << " (its frame time is not checked)" << std::endl;
+                }
+                result["timing"] = frame_timing;
+            }
+            result["passed"] = passed;
+            results.push_back(result);
+        }
+    }
+
+    nlohmann::json report = {
+        {"visual-failures", visual_failures},
+        {"timing-regressions", timing_regressions},
+        {"budget-failures", budget_failures},
+        {"missing-baselines", missing_baselines},
+        {"timing-tolerance", timing_tolerance},
+        {"results", results}};
+    std::cout << report.dump(2) << std::endl;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(report_path).parent_path(), ec);
+    std::ofstream report_out(report_path);
+    if (report_out)
+        report_out << report.dump(2) << std::endl;
+    else
+        std::cerr << "Couldn't open file: " << report_path << std::endl;
+
+    if (!missing_baselines.empty() && !update_baselines)
+        std::cerr << "WARNING: " << missing_baselines.size() << " config(s) have no timing baseline in " << baselines_path
+                  << " so their frame times were not checked (run with -update-baselines to store them)" << std::endl;
+
+    if (update_baselines)
+    {
+        std::ofstream baselines_out(baselines_path);
+        if (!baselines_out)
+        {
+            std::cerr << "Couldn't open file: " << baselines_path << std::endl;
+            return -1;
+        }
+        baselines_out << baselines.dump(2) << std::endl;
+        std::cout << "Baselines saved to: " << baselines_path << std::endl;
+    }
+
+    return visual_failures + timing_regressions + budget_failures;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <asset-loader.hpp>
+#include <material/material.hpp>
 #include <ecs/transform.hpp>
 #include <application.hpp>
 #include <deserialize-utils.hpp>
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <application.hpp>
+
+#include <ecs/world.hpp>
+#include <systems/forward-renderer.hpp>
+#include <systems/movement.hpp>
+#include <systems/car-generator.hpp>
+#include <asset-loader.hpp>
+
+// This state runs a generated stress scene (see "stress-scene.hpp") to measure how the renderer and the systems scale with the entity count.
+// It runs the same systems as the play state except the camera controller since it contains the game rules (collisions, lives, etc.).
+class StressTestState : public our::State
+{
+
+    our::World world;
+    our::ForwardRenderer renderer;
+    our::MovementSystem movementSystem;
+    our::CarGeneratorSystem carGeneratorSystem;
+
+    void onInitialize() override
+    {
+        // First of all, we get the scene configuration from the app config
+        auto &config = getApp()->getConfig()["scene"];
+        // If we have assets in the scene config, we deserialize them
+        if (config.contains("assets"))
+        {
+            our::deserializeAllAssets(config["assets"]);
+        }
+        // If we have a world in the scene config, we use it to populate our world
+        if (config.contains("world"))
+        {
+            world.deserialize(config["world"]);
+        }
+        std::cout << "Stress scene entities: " << world.getEntities().size() << std::endl;
+        // Then we initialize the renderer
+        auto size = getApp()->getFrameBufferSize();
+        renderer.initialize(size, config["renderer"]);
+    }
+
+    void onDraw(double deltaTime) override
+    {
+        movementSystem.update(&world, (float)deltaTime);
+        carGeneratorSystem.update(&world, (float)deltaTime);
+        renderer.render(&world);
+    }
+
+    void onDestroy() override
+    {
+        renderer.destroy();
+        world.clear();
+        our::clearAllAssets();
+    }
+};